@@ -36,23 +36,100 @@ void Game::init(const char *title, int xpos, int ypos, int width, int height, bo
             flags = SDL_WINDOW_FULLSCREEN;
         }
         window.reset(SDL_CreateWindow(title, xpos, ypos, width, height, flags));
-        ScreenHeightWidth = std::make_pair(width, height);
         if(window){
             renderer.reset(SDL_CreateRenderer(window.get(), -1, 0));
             if(renderer.get()){
                 SDL_SetRenderDrawColor(renderer.get(), 255, 255, 255, 255);
+                setResolution(width, height);
             }
             isRunning = true;
         }
     } else {
         isRunning = false;
     }
-    for(const std::unique_ptr<Enemy>& e : enemies){
-        e->init();
+    workers.setThreadCount(workerCount);
+}
+void Game::setResolution(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    displaySize = ScreenHeightWidth = std::make_pair(width, height);
+    resolutionScaler.reset();
+    viewTablesDirty = true;
+    if (!renderer)
+        return;
+
+    // The 3D view is rendered at this size (or a dynamic fraction of it,
+    // in the top left of frameBuffer) and scaled to the window
+    SDL_RenderSetLogicalSize(renderer.get(), width, height);
+    frameTexture.reset(SDL_CreateTexture(renderer.get(), SDL_PIXELFORMAT_ARGB8888,
+                                         SDL_TEXTUREACCESS_STREAMING, width, height));
+    frameBuffer.assign((size_t)width * height, 0);
+    if (!frameTexture) {
+        SDL_Log("Framebuffer texture error: %s", SDL_GetError());
+        useFramebuffer = false;
     }
 }
+void Game::setDynamicResolution(bool enabled, float budgetMs)
+{
+    dynamicResolution = enabled;
+    resolutionScaler.reset();
+    resolutionScaler.setBudget(budgetMs);
+}
+// Render size for the current scale; the renderer path always draws at
+// full size since it has no framebuffer to scale
+void Game::applyRenderScale()
+{
+    float scale = dynamicResolution && useFramebuffer ? resolutionScaler.scale() : 1.0f;
+    std::pair<int, int> size = {std::max(1, (int)(displaySize.first * scale + 0.5f)),
+                                std::max(2, (int)(displaySize.second * scale + 0.5f))};
+    if (size == ScreenHeightWidth)
+        return;
+    ScreenHeightWidth = size;
+    viewTablesDirty = true;
+}
+void Game::setFOV(float degrees)
+{
+    FOV = std::clamp(degrees, 1.0f, 179.0f);
+    viewTablesDirty = true;
+}
+void Game::rebuildViewTables()
+{
+    int screenW = ScreenHeightWidth.first, screenH = ScreenHeightWidth.second;
+    viewPlaneScale = tan(FOV * (3.14159f / 180.0f) / 2.0f);
+
+    // Position of each column on the camera plane, -1 (left) to 1 (right)
+    columnCameraX.resize(screenW);
+    for (int x = 0; x < screenW; x++)
+        columnCameraX[x] = 2.0f * x / screenW - 1.0f;
+
+    // Perpendicular distance of the floor (below the horizon) or ceiling
+    // (above it) seen through each screen row
+    rowDistance.resize(screenH);
+    for (int y = 0; y < screenH; y++) {
+        if (y == screenH / 2)
+            rowDistance[y] = 0.0f;   // horizon, covered by walls
+        else if (y > screenH / 2)
+            rowDistance[y] = playerHeight / ((float)y / screenH - 0.5f);
+        else
+            rowDistance[y] = playerHeight / (0.5f - (float)y / screenH);
+    }
+    viewTablesDirty = false;
+}
+void Game::setWorkerCount(int count)
+{
+    workerCount = count;
+    workers.setThreadCount(count);
+}
 void Game::handleEvents()
 {
+    applyInput(pollInput());
+}
+
+InputFrame Game::pollInput()
+{
+    ProfileScope scope(profiler, PROFILE_INPUT);
+    InputFrame input;
     SDL_Event event;
 
     while (SDL_PollEvent(&event))
@@ -66,612 +143,1368 @@ void Game::handleEvents()
             SDL_ShowCursor(SDL_DISABLE);
             SDL_SetRelativeMouseMode(SDL_TRUE);   // capture mouse
             //std::cout << "Mouse captured\n";
-            if(!hasShot){
-                shotThisFrame = true;
-                hasShot = true;
-                fireCooldown = 0.0f;
-            }
-            else{
-            //    std::cout << "Weapon still cooling down\n";
-            }
+            input.buttons |= INPUT_FIRE;
         }
 
-        // Mouse movement → rotate player
+        // F3 toggles the profiler graph; not game input, so never recorded
+        if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3 && !event.key.repeat)
+            setProfilerOverlay(!showProfiler);
+
+        // event.motion.xrel = delta X since last frame
         if (event.type == SDL_MOUSEMOTION)
-        {
-            // event.motion.xrel = delta X since last frame
-            playerAngle += event.motion.xrel * mouseSensitivity;
-            playerAngle = fmod(playerAngle, 2 * PI);
-        }
+            input.mouseDX += event.motion.xrel;
     }
 
     // Keyboard movement detection
     const Uint8* keystate = SDL_GetKeyboardState(NULL);
 
-    playerMoveDirection = {0.0f, 0.0f};
-
-    // Forward
-    if (keystate[SDL_SCANCODE_W] || keystate[SDL_SCANCODE_UP]) {
-        playerMoveDirection.first += cos(playerAngle);
-        playerMoveDirection.second += sin(playerAngle);
-    }
+    if (keystate[SDL_SCANCODE_W] || keystate[SDL_SCANCODE_UP])
+        input.buttons |= INPUT_FORWARD;
+    if (keystate[SDL_SCANCODE_S] || keystate[SDL_SCANCODE_DOWN])
+        input.buttons |= INPUT_BACK;
+    if (keystate[SDL_SCANCODE_A])
+        input.buttons |= INPUT_STRAFE_LEFT;
+    if (keystate[SDL_SCANCODE_D])
+        input.buttons |= INPUT_STRAFE_RIGHT;
+    if (keystate[SDL_SCANCODE_LEFT])
+        input.buttons |= INPUT_TURN_LEFT;
+    if (keystate[SDL_SCANCODE_RIGHT])
+        input.buttons |= INPUT_TURN_RIGHT;
+    if (keystate[SDL_SCANCODE_SPACE])
+        input.buttons |= INPUT_USE;
 
-    // Backward
-    if (keystate[SDL_SCANCODE_S] || keystate[SDL_SCANCODE_DOWN]) {
-        playerMoveDirection.first -= cos(playerAngle);
-        playerMoveDirection.second -= sin(playerAngle);
-    }
+    return input;
+}
 
-    // Strafe Left (A)
-    if (keystate[SDL_SCANCODE_A]) {
-        playerMoveDirection.first += cos(playerAngle - 3.14159f/2);
-        playerMoveDirection.second += sin(playerAngle - 3.14159f/2);
+void Game::applyInput(const InputFrame& input)
+{
+    ProfileScope scope(profiler, PROFILE_INPUT);
+    if (input.buttons & INPUT_FIRE)
+    {
+        if(!hasShot){
+            shotPending = true;
+            hasShot = true;
+            fireCooldown = 0.0f;
+        }
+        else{
+        //    std::cout << "Weapon still cooling down\n";
+        }
     }
 
-    // Strafe Right (D)
-    if (keystate[SDL_SCANCODE_D]) {
-        playerMoveDirection.first += cos(playerAngle + 3.14159f/2);
-        playerMoveDirection.second += sin(playerAngle + 3.14159f/2);
+    // Mouse movement → rotate player, straight away rather than per tick
+    if (input.mouseDX != 0)
+    {
+        playerAngle += input.mouseDX * mouseSensitivity;
+        playerAngle = fmod(playerAngle, 2 * PI);
     }
 
-    // Optional keyboard turning (can keep or remove)
-    if (keystate[SDL_SCANCODE_LEFT])
-        playerAngle -= rotationSensitivity;
+    // Movement and keyboard turning run in the simulation tick
+    heldButtons = input.buttons;
 
-    if (keystate[SDL_SCANCODE_RIGHT])
-        playerAngle += rotationSensitivity;
-
-    // Door interaction (Space to open/close)
     // Door interaction (Space to open/close)
-    if (keystate[SDL_SCANCODE_SPACE])
+    if (input.buttons & INPUT_USE)
     {
         int tx = (int)(playerPosition.first  + cos(playerAngle) * playerSquareSize *1.1f);
         int ty = (int)(playerPosition.second + sin(playerAngle) * playerSquareSize *1.1f);
 
-        auto key = std::make_pair(ty, tx);
-        if (doors.count(key)) {
-            Door& d = doors[key];
+        tryOpenDoor(tx, ty);
+    }
 
-            if (d.locked && !playerHasKey(d.keyType))
-                return;
+}
 
-            if (d.openAmount == 0.0f)
-                d.opening = true;
-        }
+void Game::advance(float frameSeconds)
+{
+    // A long stall (breakpoint, window drag) would otherwise be replayed as
+    // a burst of ticks
+    tickAccumulator += std::min(frameSeconds, 0.25f);
+    while (tickAccumulator >= TICK_SECONDS) {
+        update(TICK_SECONDS);
+        tickAccumulator -= TICK_SECONDS;
     }
-
+    renderAlpha = tickAccumulator / TICK_SECONDS;
 }
 
 void Game::update(float deltaTime)
 {
-    // Normalize movement direction
-    float lengthSquared = playerMoveDirection.first * playerMoveDirection.first +
-    playerMoveDirection.second * playerMoveDirection.second;
-
-    if (lengthSquared > 0.0f) {
-        float length = sqrt(lengthSquared);
-        playerMoveDirection.first /= length;
-        playerMoveDirection.second /= length;
-    }
-
-    // Collision detection and position update
-    float newX = playerPosition.first + playerMoveDirection.first * playerSpeed * deltaTime;
-    float newY = playerPosition.second + playerMoveDirection.second * playerSpeed * deltaTime;
-    int mx = (int)newX;
-    int my = (int)playerPosition.second;
-    if (my < 0 || my >= Map.size()) return;
-    if (mx < 0 || mx >= Map[my].size()) return;
-
-    int tileX = Map[(int)playerPosition.second][(int)(newX + playerSquareSize * (newX>playerPosition.first?1:-1))];
-    int tileY = Map[(int)(newY + playerSquareSize * (newY>playerPosition.second?1:-1))][(int)playerPosition.first];
-    if (tileX == 0 ||
-        (isDoor(tileX) &&
-        doors[{(int)playerPosition.second,
-                (int)(newX + playerSquareSize * (newX > playerPosition.first ? 1 : -1))}]
-            .openAmount > 0.5f))
     {
-        if (!collidesWithEnemy(newX, playerPosition.second)) {
-            playerPosition.first = newX;
+        ProfileScope scope(profiler, PROFILE_PLAYER);
+        prevPlayerPosition = playerPosition;
+
+        // Optional keyboard turning (can keep or remove)
+        lastTickTurn = 0.0f;
+        if (heldButtons & INPUT_TURN_LEFT)
+            lastTickTurn -= turnSpeed * deltaTime;
+        if (heldButtons & INPUT_TURN_RIGHT)
+            lastTickTurn += turnSpeed * deltaTime;
+        playerAngle += lastTickTurn;
+
+        playerMoveDirection = {0.0f, 0.0f};
+
+        // Forward
+        if (heldButtons & INPUT_FORWARD) {
+            playerMoveDirection.first += cos(playerAngle);
+            playerMoveDirection.second += sin(playerAngle);
+        }
+
+        // Backward
+        if (heldButtons & INPUT_BACK) {
+            playerMoveDirection.first -= cos(playerAngle);
+            playerMoveDirection.second -= sin(playerAngle);
+        }
+
+        // Strafe Left (A)
+        if (heldButtons & INPUT_STRAFE_LEFT) {
+            playerMoveDirection.first += cos(playerAngle - 3.14159f/2);
+            playerMoveDirection.second += sin(playerAngle - 3.14159f/2);
+        }
+
+        // Strafe Right (D)
+        if (heldButtons & INPUT_STRAFE_RIGHT) {
+            playerMoveDirection.first += cos(playerAngle + 3.14159f/2);
+            playerMoveDirection.second += sin(playerAngle + 3.14159f/2);
+        }
+
+        // Normalize movement direction
+        float lengthSquared = playerMoveDirection.first * playerMoveDirection.first +
+        playerMoveDirection.second * playerMoveDirection.second;
+
+        if (lengthSquared > 0.0f) {
+            float length = sqrt(lengthSquared);
+            playerMoveDirection.first /= length;
+            playerMoveDirection.second /= length;
+        }
+
+        // Collision detection and position update
+        float newX = playerPosition.first + playerMoveDirection.first * playerSpeed * deltaTime;
+        float newY = playerPosition.second + playerMoveDirection.second * playerSpeed * deltaTime;
+        int mx = (int)newX;
+        int my = (int)playerPosition.second;
+        if (!Map.inBounds(mx, my)) return;
+
+        // Probes are at most one tile past the player and read the border there
+        int probeX = (int)(newX + playerSquareSize * (newX>playerPosition.first?1:-1));
+        int probeY = (int)(newY + playerSquareSize * (newY>playerPosition.second?1:-1));
+        int tileX = Map.get(probeX, (int)playerPosition.second);
+        int tileY = Map.get((int)playerPosition.first, probeY);
+        if (tileX == 0 ||
+            (isDoor(tileX) && !doorBlocks(probeX, (int)playerPosition.second)))
+        {
+            if (!collidesWithEnemy(newX, playerPosition.second)) {
+                playerPosition.first = newX;
+            }
+        }
+
+        if (tileY == 0 ||
+            (isDoor(tileY) && !doorBlocks((int)playerPosition.first, probeY)))
+        {
+            if (!collidesWithEnemy(playerPosition.first, newY)) {
+                playerPosition.second = newY;
+            }
         }
     }
 
-    if (tileY == 0 ||
-        (isDoor(tileY) &&
-        doors[{(int)(newY + playerSquareSize * (newY > playerPosition.second ? 1 : -1)),
-                (int)playerPosition.first}]
-            .openAmount > 0.5f))
     {
-        if (!collidesWithEnemy(playerPosition.first, newY)) {
-            playerPosition.second = newY;
-        }
+        ProfileScope scope(profiler, PROFILE_DOORS);
+        updateDoors(deltaTime);
     }
 
-    // Update doors
-    for (auto& [pos, d] : doors)
+    tickCount++;
+
+    // Update enemies in parallel bands. Each enemy only touches its own
+    // slots and its own random stream, so the result does not depend on the
+    // thread count; shared writes (grid cells, player damage) are gathered
+    // per band and applied afterwards in band order.
+    int enemyCount = enemies.count();
+    int bandCount = (enemyCount + enemyBandSize - 1) / enemyBandSize;
+    enemyBandMoves.resize(bandCount);
+    enemyBandDamage.assign(bandCount, 0);
+    float px = playerPosition.first, py = playerPosition.second;
     {
-        if (d.opening) {
-            d.openAmount += 1.5f * deltaTime;
-            if (d.openAmount >= 1.0f) {
-                d.openAmount = 1.0f;
-                d.opening = false;
+        ProfileScope scope(profiler, PROFILE_ENEMY_AI);
+        workers.parallelFor(enemyCount, enemyBandSize, [&](int begin, int end) {
+            std::vector<int>& moved = enemyBandMoves[begin / enemyBandSize];
+            moved.clear();
+            for (int i = begin; i < end; i++) {
+                // Out of sight: think every AI_LOD_TICKS ticks (staggered by
+                // id) with the time of all of them, drawn gliding over the
+                // whole stride. Sight comes from the baked PVS, or on maps too
+                // large to bake, from the line of sight of the previous tick;
+                // neither depends on what was drawn, so demos replay the same
+                // at any resolution or frame rate.
+                int ticks = 1;
+                if (aiLod) {
+                    int ex = (int)floorf(enemies.position(i).first), ey = (int)floorf(enemies.position(i).second);
+                    bool inSight = pvs.empty() ? enemies.seesPlayer(i)
+                                               : pvs.mayBeVisible(ex, ey, (int)floorf(px), (int)floorf(py));
+                    if (!inSight)
+                        ticks = AI_LOD_TICKS;
+                }
+                if ((tickCount + i) % ticks == 0) {
+                    enemies.beginStep(i, ticks);
+                    enemies.process(i, deltaTime * ticks, px, py);
+                }
+                else
+                    enemies.skipTick(i);
+                if (enemyGrid.changesCell(i, enemies.position(i).first, enemies.position(i).second))
+                    moved.push_back(i);
             }
-        }
+        });
+        for (const std::vector<int>& moved : enemyBandMoves)
+            for (int i : moved)
+                enemyGrid.move(i, enemies.position(i).first, enemies.position(i).second);
     }
 
-    // Update enemies
-    for(const std::unique_ptr<Enemy>& e : enemies){
-        e->_process(deltaTime, playerPosition);
-
-        // Update canSeePlayer
-        bool x = rayCastEnemyToPlayer(*e);
-        e->updateCanSeePlayer(x);
-        int dmg = e->getDamageThisFrame();
-        e->clearDamageThisFrame();
-        if(x && dmg > 0){
-            health -= dmg;
-            if(health < 0) health = 0;
+    // Update canSeePlayer
+    {
+        ProfileScope scope(profiler, PROFILE_LOS);
+        workers.parallelFor(enemyCount, enemyBandSize, [&](int begin, int end) {
+            int& damage = enemyBandDamage[begin / enemyBandSize];
+            for (int i = begin; i < end; i++) {
+                bool x = rayCastEnemyToPlayer(i);
+                enemies.setCanSeePlayer(i, x);
+                int dmg = enemies.takeDamageDealt(i);
+                if (x && dmg > 0)
+                    damage += dmg;
+            }
+        });
+    }
+    for (int dmg : enemyBandDamage) {
+        health -= dmg;
+        if(health < 0) health = 0;
+    //std::cout << "Player Health: " << health << std::endl;
+    }
 
-        // Update Alerts
-        if(shotThisFrame && weaponMultiplier > 1 && !e->isAlerted()){
-            float dist = distSq(playerPosition, e->get_position());
-            dist = pow(dist, 0.5f);
-            if(dist <= alertRange)
-                e->alert();
+    // A shot fired since the last tick hits the enemy under the crosshair
+    // and wakes every enemy within earshot; resolved here, however many
+    // frames were drawn in between
+    if(shotPending){
+        int target = findShotTarget();
+        if (target != -1) {
+            float dist = sqrt(distSq(playerPosition, enemies.position(target)));
+            int dmg=0;
+            if(canShootEnemy(dist))
+                dmg = rng.nextInt(32) * weaponMultiplier;
+            //std::cout << "Enemy at index " << target << " shot for " << dmg << " damage.\n";
+            if (rayCastEnemyToPlayer(target))
+                enemies.takeDamage(target, dmg);
         }
-    //std::cout << "Player Health: " << health << std::endl;
+        if(weaponMultiplier > 1){
+            enemyGrid.forEachInBox(px - alertRange, py - alertRange, px + alertRange, py + alertRange,
+                [&](int id) {
+                    if(!enemies.isAlerted(id) && distSq(playerPosition, enemies.position(id)) <= alertRange * alertRange)
+                        enemies.alert(id);
+                });
         }
+        shotPending = false;
     }
     if(hasShot){
         fireCooldown += deltaTime;
-        if(fireCooldown >= fireDuration){
+        if(fireCooldown >= fireDuration)
             hasShot = false;
-            shotThisFrame = false;
-        }
     }
 }
 
 void Game::render()
 {
-    SDL_SetRenderDrawColor(renderer.get(), 40, 40, 40, 255);
-    SDL_RenderClear(renderer.get());   
-    std::vector<float> zBuffer(ScreenHeightWidth.first);
+    applyRenderScale();
+    int screenW = ScreenHeightWidth.first, screenH = ScreenHeightWidth.second;
+    zBuffer.assign(screenW, 0.0f);
+
+    if (viewTablesDirty)
+        rebuildViewTables();
+
+    // Draw where the player is between the last two ticks
+    viewPosition.first  = prevPlayerPosition.first  + (playerPosition.first  - prevPlayerPosition.first)  * renderAlpha;
+    viewPosition.second = prevPlayerPosition.second + (playerPosition.second - prevPlayerPosition.second) * renderAlpha;
+    float viewAngle = playerAngle - lastTickTurn * (1.0f - renderAlpha);
+
+    // The only trig of the frame: rotate the camera basis by the view angle
+    viewDirX = cos(viewAngle);
+    viewDirY = sin(viewAngle);
+    viewPlaneX = -viewDirY * viewPlaneScale;
+    viewPlaneY =  viewDirX * viewPlaneScale;
+
+    if (useFramebuffer) {
+        // Ceiling background on top, floor colour below (overwritten by
+        // the floor texture if there is one).
+        std::fill(frameBuffer.begin(), frameBuffer.begin() + screenW * (screenH / 2), 0xFF282828u);
+        std::fill(frameBuffer.begin() + screenW * (screenH / 2), frameBuffer.begin() + screenW * screenH,
+                  0xFF646464u);
+    }
+    else {
+        SDL_SetRenderDrawColor(renderer.get(), 40, 40, 40, 255);
+        SDL_RenderClear(renderer.get());
+
+        // Draw floor
+        if (floorTextures.size() == 0) {
+            SDL_SetRenderDrawColor(renderer.get(), 100, 100, 100, 255);
+            SDL_Rect floorRect = {0, screenH / 2, screenW, screenH / 2};
+            SDL_RenderFillRect(renderer.get(), &floorRect);
+        }
+    }
 
-    // Draw floor
-    if (floorTextures.size() == 0) {
-        SDL_SetRenderDrawColor(renderer.get(), 100, 100, 100, 255);
-        SDL_Rect floorRect = {0, ScreenHeightWidth.second / 2, ScreenHeightWidth.first, ScreenHeightWidth.second / 2};
-        SDL_RenderFillRect(renderer.get(), &floorRect);
+    // Raycasting for walls, floor and ceiling. Columns only share zBuffer,
+    // one slot each, so the framebuffer path renders them as parallel bands.
+    // parallelFor returns once every band is done, before sprites read zBuffer.
+    // Ceiling and floor rows are separate jobs so each gets its own timing.
+    if (useFramebuffer) {
+        // Floor and ceiling go in first as whole scanlines, walls overwrite them
+        {
+            ProfileScope scope(profiler, PROFILE_CEILING);
+            workers.parallelFor(screenH / 2, rowBandHeight, [this](int begin, int end) {
+                renderFloorAndCeilingRows(begin, end);
+            });
+        }
+        {
+            ProfileScope scope(profiler, PROFILE_FLOOR);
+            int floorStart = screenH / 2 + 1;
+            workers.parallelFor(screenH - floorStart, rowBandHeight, [this, floorStart](int begin, int end) {
+                renderFloorAndCeilingRows(floorStart + begin, floorStart + end);
+            });
+        }
+        ProfileScope scope(profiler, PROFILE_WALLS);
+        beginVisibleTiles(screenW);
+        workers.parallelFor(screenW, columnBandWidth, [this](int begin, int end) {
+            for (int ray = begin; ray < end; ray++)
+                renderColumn(ray);
+        });
+        collectVisibleTiles();
     }
-    // Raycasting for walls
-    int raysCount = ScreenHeightWidth.first;
-    float fovRad = FOV * (3.14159f / 180.0f);
-    float halfFov = fovRad / 2.0f;
+    else {
+        ProfileScope scope(profiler, PROFILE_WALLS);
+        beginVisibleTiles(screenW);
+        wallColumns.resize(screenW);
+        for (int ray = 0; ray < screenW; ray++)
+            renderColumn(ray);
+        collectVisibleTiles();
+        renderWallQuads();
+    }
+
+    renderEnemies();
 
-    for (int ray = 0; ray < raysCount; ray++)
     {
-        // Angle of this ray
-        float rayAngle = playerAngle - halfFov + ray * (fovRad / raysCount);
+        ProfileScope scope(profiler, PROFILE_PRESENT);
+        if (useFramebuffer) {
+            // One upload and one copy for the whole frame, stretched to
+            // full size when rendered at a lower resolution
+            SDL_Rect view = {0, 0, screenW, screenH};
+            SDL_UpdateTexture(frameTexture.get(), &view, frameBuffer.data(),
+                              screenW * (int)sizeof(uint32_t));
+            SDL_RenderCopy(renderer.get(), frameTexture.get(), &view, nullptr);
+        }
+        if (showProfiler)
+            renderProfilerOverlay();
+        SDL_RenderPresent(renderer.get()); 
+    }
+    profiler.endFrame();
 
-        // Ray direction
-        float rayDirX = cos(rayAngle);
-        float rayDirY = sin(rayAngle);
+    // The new size takes effect next frame
+    ProfileFrame last;
+    if (dynamicResolution && useFramebuffer && profiler.frame(0, last))
+        resolutionScaler.addFrame(last.totalMs);
+}
 
-        // Map tile the ray starts in
-        int mapX = (int)playerPosition.first;
-        int mapY = (int)playerPosition.second;
+void Game::setProfilerOverlay(bool enabled)
+{
+    showProfiler = enabled;
+    if (!enabled)
+        return;
+    // No text rendering, so the graph legend goes to the console
+    std::cout << "Profiler (bottom to top):";
+    for (int z = 0; z < PROFILE_ZONE_COUNT; z++)
+        std::cout << " " << profileZoneName(z);
+    std::cout << "\nWhite line = 16.7 ms (60 FPS)\n"
+              << "Cyan bar on top = dynamic render scale (full width = 100%)\n";
+}
 
-        // Length of ray from one x-side to next x-side
-        float deltaDistX = (rayDirX == 0) ? 1e30 : fabs(1.0f / rayDirX);
-        // Length of ray from one y-side to next y-side
-        float deltaDistY = (rayDirY == 0) ? 1e30 : fabs(1.0f / rayDirY);
+// Zone colours for the overlay, in ProfileZone order
+static const SDL_Color profileZoneColours[PROFILE_ZONE_COUNT] = {
+    {200, 200, 200, 255},   // input
+    { 60, 160, 255, 255},   // player
+    {  0, 200, 200, 255},   // doors
+    {255, 200,   0, 255},   // enemy AI
+    {255, 120,   0, 255},   // LOS
+    {220,  40,  40, 255},   // walls
+    { 60, 200,  60, 255},   // floor
+    { 30, 120,  30, 255},   // ceiling
+    {200,  80, 200, 255},   // sprite sort
+    {140,  40, 200, 255},   // sprite draw
+    {120, 120, 120, 255},   // present
+};
 
-        int stepX, stepY;
-        float sideDistX, sideDistY;
+void Game::renderProfilerOverlay()
+{
+    // Drawn in window pixels over the scaled view, so it keeps its size
+    // and sits on the window's bottom edge whatever the resolution
+    int screenW, screenH;
+    SDL_RenderSetLogicalSize(renderer.get(), 0, 0);
+    SDL_GetRendererOutputSize(renderer.get(), &screenW, &screenH);
+
+    // One pixel per frame, newest on the right; 33 ms fills the graph
+    int graphW = std::min(screenW, FrameProfiler::HISTORY);
+    int graphH = screenH / 4;
+    float pixelsPerMs = graphH / 33.3f;
+    int left = 0, bottom = screenH;
+
+    SDL_Rect background = {left, bottom - graphH, graphW, graphH};
+    SDL_SetRenderDrawColor(renderer.get(), 0, 0, 0, 255);
+    SDL_RenderFillRect(renderer.get(), &background);
+
+    // Stacked bars, batched into one fill call per zone
+    std::vector<SDL_Rect> zoneRects[PROFILE_ZONE_COUNT];
+    ProfileFrame f;
+    for (int age = 0; age < graphW && profiler.frame(age, f); age++) {
+        int x = left + graphW - 1 - age;
+        float stacked = 0.0f;
+        for (int z = 0; z < PROFILE_ZONE_COUNT; z++) {
+            int y0 = bottom - (int)(stacked * pixelsPerMs);
+            stacked += f.zoneMs[z];
+            int y1 = std::max(bottom - (int)(stacked * pixelsPerMs), bottom - graphH);
+            if (y1 < y0)
+                zoneRects[z].push_back({x, y1, 1, y0 - y1});
+        }
+    }
+    for (int z = 0; z < PROFILE_ZONE_COUNT; z++) {
+        if (zoneRects[z].empty())
+            continue;
+        const SDL_Color& c = profileZoneColours[z];
+        SDL_SetRenderDrawColor(renderer.get(), c.r, c.g, c.b, 255);
+        SDL_RenderFillRects(renderer.get(), zoneRects[z].data(), (int)zoneRects[z].size());
+    }
 
-        // Step direction and initial side distances
-        if (rayDirX < 0) {
-            stepX = -1;
-            sideDistX = (playerPosition.first - mapX) * deltaDistX;
-        } else {
-            stepX = 1;
-            sideDistX = (mapX + 1.0f - playerPosition.first) * deltaDistX;
+    // 60 FPS budget
+    SDL_Rect budget = {left, bottom - (int)(16.7f * pixelsPerMs), graphW, 1};
+    SDL_SetRenderDrawColor(renderer.get(), 255, 255, 255, 255);
+    SDL_RenderFillRect(renderer.get(), &budget);
+
+    // Render scale of the 3D view
+    if (dynamicResolution && useFramebuffer) {
+        SDL_Rect scaleBar = {left, bottom - graphH - 3, (int)(graphW * resolutionScaler.scale()), 3};
+        SDL_SetRenderDrawColor(renderer.get(), 0, 255, 255, 255);
+        SDL_RenderFillRect(renderer.get(), &scaleBar);
+    }
+
+    SDL_RenderSetLogicalSize(renderer.get(), displaySize.first, displaySize.second);
+}
+
+// The wall pass records the tiles each column band's rays cross; the
+// bands are merged into seenTiles afterwards so no two threads share a list
+void Game::beginVisibleTiles(int columns)
+{
+    seenBandTiles.resize((columns + columnBandWidth - 1) / columnBandWidth);
+    seenBandSquares.resize(seenBandTiles.size());
+    for (std::vector<int>& band : seenBandTiles)
+        band.clear();
+    for (std::vector<int>& band : seenBandSquares)
+        band.clear();
+}
+
+void Game::collectVisibleTiles()
+{
+    // Clear last frame's bits through its list rather than the whole map
+    size_t words = ((size_t)Map.indexCount() + 63) / 64;
+    if (seenTileBits.size() != words)
+        seenTileBits.assign(words, 0);
+    else
+        for (int index : seenTileList)
+            seenTileBits[index >> 6] = 0;
+    seenTileList.clear();
+
+    auto mark = [this](int index) {
+        uint64_t bit = 1ull << (index & 63);
+        if (seenTileBits[index >> 6] & bit)
+            return;
+        seenTileBits[index >> 6] |= bit;
+        seenTileList.push_back(index);
+    };
+    for (const std::vector<int>& band : seenBandTiles)
+        for (int index : band)
+            mark(index);
+
+    // A ray that jumped an open square may have passed any tile of it;
+    // many rays jump from the same tiles, so mark each square once
+    seenSquareList.clear();
+    for (const std::vector<int>& band : seenBandSquares)
+        seenSquareList.insert(seenSquareList.end(), band.begin(), band.end());
+    std::sort(seenSquareList.begin(), seenSquareList.end());
+    seenSquareList.erase(std::unique(seenSquareList.begin(), seenSquareList.end()), seenSquareList.end());
+    int stride = Map.width() + 2;
+    for (int centre : seenSquareList) {
+        int cx = centre % stride - 1, cy = centre / stride - 1;
+        int reach = wallDistance.at(cx, cy) - 1;
+        for (int y = cy - reach; y <= cy + reach; y++)
+            for (int x = cx - reach; x <= cx + reach; x++)
+                mark(Map.index(x, y));
+    }
+}
+
+// Whether the last frame's wall pass saw any tile under a one tile wide
+// sprite at (x, y): its own tile can be hidden while an edge shows
+bool Game::areaSeen(float x, float y) const
+{
+    if (seenTileBits.empty())
+        return false;
+    int x0 = std::clamp((int)floorf(x - 0.5f), -1, Map.width()), x1 = std::clamp((int)floorf(x + 0.5f), -1, Map.width());
+    int y0 = std::clamp((int)floorf(y - 0.5f), -1, Map.height()), y1 = std::clamp((int)floorf(y + 0.5f), -1, Map.height());
+    for (int ty = y0; ty <= y1; ty++)
+        for (int tx = x0; tx <= x1; tx++) {
+            int index = Map.index(tx, ty);
+            if (seenTileBits[index >> 6] & (1ull << (index & 63)))
+                return true;
         }
+    return false;
+}
+
+// Columns per slice of a wall quad. RenderGeometry interpolates texture
+// coordinates linearly, so quads are cut into slices with exact
+// coordinates at every cut to stay close to perspective correct.
+static constexpr int WALL_SLICE = 8;
+
+// Renderer path: runs of columns on the same face of the same tile become
+// one quad, in slices, shaded through vertex colours; quads are batched per
+// texture so the walls take one draw call per texture in view
+void Game::renderWallQuads()
+{
+    wallBatches.resize(wallTextures.size());
+    for (GeometryBatch& batch : wallBatches) {
+        batch.vertices.clear();
+        batch.indices.clear();
+    }
 
-        if (rayDirY < 0) {
-            stepY = -1;
-            sideDistY = (playerPosition.second - mapY) * deltaDistY;
+    int screenW = (int)wallColumns.size();
+    for (int begin = 0; begin < screenW; ) {
+        const WallColumn& first = wallColumns[begin];
+        int end = begin + 1;
+        if (first.texId >= 0)
+            while (end < screenW && wallColumns[end].texId == first.texId &&
+                   wallColumns[end].tileIndex == first.tileIndex && wallColumns[end].side == first.side)
+                end++;
+        if (first.texId < 0) {
+            begin = end;
+            continue;
+        }
+
+        // Cut positions: every WALL_SLICE columns and the run's right edge,
+        // which continues the last column's step (flat for 1 column runs)
+        GeometryBatch& batch = wallBatches[first.texId];
+        for (int x = begin; ; x = std::min(x + WALL_SLICE, end)) {
+            WallColumn c;
+            if (x < end)
+                c = wallColumns[x];
+            else {
+                const WallColumn& last = wallColumns[end - 1];
+                const WallColumn& prev = wallColumns[end > begin + 1 ? end - 2 : end - 1];
+                c = last;
+                c.u = std::clamp(2.0f * last.u - prev.u, 0.0f, 1.0f);
+                c.top = 2.0f * last.top - prev.top;
+                c.bottom = 2.0f * last.bottom - prev.bottom;
+            }
+            SDL_Color colour = { c.brightness, c.brightness, c.brightness, 255 };
+            int base = (int)batch.vertices.size();
+            batch.vertices.push_back({ {(float)x, c.top},    colour, {c.u, 0.0f} });
+            batch.vertices.push_back({ {(float)x, c.bottom}, colour, {c.u, 1.0f} });
+            if (x > begin)
+                for (int i : {-2, 0, 1, -2, 1, -1})
+                    batch.indices.push_back(base + i);
+            if (x == end)
+                break;
+        }
+        begin = end;
+    }
+
+    for (size_t tex = 0; tex < wallBatches.size(); tex++)
+        if (!wallBatches[tex].indices.empty())
+            SDL_RenderGeometry(renderer.get(), wallTextures[tex].get(),
+                               wallBatches[tex].vertices.data(), (int)wallBatches[tex].vertices.size(),
+                               wallBatches[tex].indices.data(), (int)wallBatches[tex].indices.size());
+}
+
+// Texture for a floor/ceiling layer tile: ids start at 1 like wall ids,
+// 0 (unpainted) and unknown ids use the first texture
+static int layerTextureIndex(TileGrid::Tile tile, size_t textureCount)
+{
+    return tile >= 1 && tile <= textureCount ? tile - 1 : 0;
+}
+
+void Game::renderColumn(int ray)
+{
+    int screenW = ScreenHeightWidth.first, screenH = ScreenHeightWidth.second;
+
+    // Ray direction through this column of the camera plane. The ray is not
+    // normalised, so DDA distances come out perpendicular to the view plane
+    // and need no fisheye correction.
+    float cameraX = columnCameraX[ray];
+    float rayDirX = viewDirX + viewPlaneX * cameraX;
+    float rayDirY = viewDirY + viewPlaneY * cameraX;
+
+    // Map tile the ray starts in
+    int mapX = (int)viewPosition.first;
+    int mapY = (int)viewPosition.second;
+    if (!useFramebuffer)
+        wallColumns[ray].texId = -1;
+    if (!Map.inBounds(mapX, mapY))
+        return;
+
+    // Length of ray from one x-side to next x-side
+    float deltaDistX = (rayDirX == 0) ? 1e30 : fabs(1.0f / rayDirX);
+    // Length of ray from one y-side to next y-side
+    float deltaDistY = (rayDirY == 0) ? 1e30 : fabs(1.0f / rayDirY);
+
+    int stepX, stepY;
+    float sideDistX, sideDistY;
+
+    // Step direction and initial side distances
+    if (rayDirX < 0) {
+        stepX = -1;
+        sideDistX = (viewPosition.first - mapX) * deltaDistX;
+    } else {
+        stepX = 1;
+        sideDistX = (mapX + 1.0f - viewPosition.first) * deltaDistX;
+    }
+
+    if (rayDirY < 0) {
+        stepY = -1;
+        sideDistY = (viewPosition.second - mapY) * deltaDistY;
+    } else {
+        stepY = 1;
+        sideDistY = (mapY + 1.0f - viewPosition.second) * deltaDistY;
+    }
+
+    bool hitWall = false;
+    int hitSide = 0; // 0 = vertical hit, 1 = horizontal hit
+    float doorOpen = 0.0f;
+
+    // The solid border stops every ray. Every tile on the way goes to this
+    // band's part of the visible set, and every open square jumped over
+    // goes there by its centre.
+    int tile = 0;
+    std::vector<int>& seen = seenBandTiles[ray / columnBandWidth];
+    std::vector<int>& jumpedFrom = seenBandSquares[ray / columnBandWidth];
+    seen.push_back(Map.index(mapX, mapY));
+
+    while (!hitWall)
+    {
+        // Far from walls, cross the open square around this tile without
+        // reading its tiles
+        int fromX = mapX, fromY = mapY;
+        if (wallDistance.jump(mapX, mapY, sideDistX, sideDistY, deltaDistX, deltaDistY, stepX, stepY))
+            jumpedFrom.push_back(Map.index(fromX, fromY));
+
+        // Jump to next grid square
+        if (sideDistX < sideDistY) {
+            sideDistX += deltaDistX;
+            mapX += stepX;
+            hitSide = 0;
         } else {
-            stepY = 1;
-            sideDistY = (mapY + 1.0f - playerPosition.second) * deltaDistY;
+            sideDistY += deltaDistY;
+            mapY += stepY;
+            hitSide = 1;
         }
 
-        bool hitWall = false;
-        int hitSide = 0; // 0 = vertical hit, 1 = horizontal hit
+        seen.push_back(Map.index(mapX, mapY));
 
-        while (!hitWall)
+        // Check if the ray hit a wall; only solid tiles are 0 in the field
+        tile = wallDistance.at(mapX, mapY) == 0 ? Map.at(mapX, mapY) : 0;
+        if (tile > 0 && !isDoor(tile)) {
+            hitWall = true;
+        }
+        else if (isDoor(tile))
         {
-            // Jump to next grid square
-            if (sideDistX < sideDistY) {
-                sideDistX += deltaDistX;
-                mapX += stepX;
-                hitSide = 0;
+            // A door tile without a door entry draws as a closed door
+            doorOpen = doorOpenAmount(Map.doorAt(mapX, mapY));
+            
+            // --- compute hit distance ---
+            float hitDist = (hitSide == 0 ? sideDistX - deltaDistX
+                                        : sideDistY - deltaDistY);
+
+            // exact float hit position
+            float hitX = viewPosition.first  + rayDirX * hitDist;
+            float hitY = viewPosition.second + rayDirY * hitDist;
+
+            // local coords inside tile (0..1)
+            float localX = hitX - floor(hitX);
+            float localY = hitY - floor(hitY);
+
+            bool blocks = false;
+
+            if (hitSide == 0) {
+                // vertical → opening affects Y movement
+                // door blocks if hit Y is beyond open amount
+                blocks = (localY >= doorOpen);
             } else {
-                sideDistY += deltaDistY;
-                mapY += stepY;
-                hitSide = 1;
+                // horizontal → opening affects X movement
+                blocks = (localX >= doorOpen);
             }
 
-            // Check if the ray hit a wall
-            if (Map[mapY][mapX] > 0 && !isDoor(Map[mapY][mapX])) {
-                hitWall = true;
-            }
-            else if (isDoor(Map[mapY][mapX]))
-            {
-                float open = 0.0f;
-                auto it = doors.find({mapY, mapX});
-                if (it != doors.end()) {
-                    open = it->second.openAmount;
-                } else {
-                    std::cout << "Door at "<<mapY<<", "<<mapX<<" not found\n";
-                    return;
-                }
-                
-                // --- compute hit distance ---
-                float hitDist = (hitSide == 0 ? sideDistX - deltaDistX
-                                            : sideDistY - deltaDistY);
-
-                // exact float hit position
-                float hitX = playerPosition.first  + rayDirX * hitDist;
-                float hitY = playerPosition.second + rayDirY * hitDist;
-
-                // local coords inside tile (0..1)
-                float localX = hitX - floor(hitX);
-                float localY = hitY - floor(hitY);
-
-                bool blocks = false;
-
-                if (hitSide == 0) {
-                    // vertical → opening affects Y movement
-                    // door blocks if hit Y is beyond open amount
-                    blocks = (localY >= open);
-                } else {
-                    // horizontal → opening affects X movement
-                    blocks = (localX >= open);
-                }
+            if (blocks)
+                hitWall = true;      // ray stops here
+            else
+                hitWall = false;     // ray passes through (door is open)
+        }
 
-                if (blocks)
-                    hitWall = true;      // ray stops here
-                else
-                    hitWall = false;     // ray passes through (door is open)
-            }
+    }
+
+    // Distance to wall = distance to side where hit happened
+    float distanceToWall;
+    if (hitSide == 0)
+        distanceToWall = sideDistX - deltaDistX;
+    else
+        distanceToWall = sideDistY - deltaDistY;
 
+    float hitX = viewPosition.first  + rayDirX * distanceToWall;
+    float hitY = viewPosition.second + rayDirY * distanceToWall;
+    float wallX;
+    if (hitSide == 0)
+        wallX = hitY - floor(hitY);
+    else
+        wallX = hitX - floor(hitX);
+    float correctedDistance = distanceToWall;
+    zBuffer[ray] = correctedDistance;
+
+    // Calculate wall height
+    int lineHeight = (int)(screenH / correctedDistance);
+    int wallTop   = -lineHeight / 2 + screenH / 2;
+    int drawStart = wallTop;
+    int drawEnd   =  lineHeight / 2 + screenH / 2;
+
+    if (drawStart < 0) drawStart = 0;
+    if (drawEnd >= screenH) drawEnd = screenH - 1;
+
+    // Wall Texture; ids without a texture (maps and .lvl files allow any
+    // tile id) fall back to the first one, like floor and ceiling tiles
+    if (wallPixels.empty())
+        return;
+    int texId = layerTextureIndex(tile, wallPixels.size());
+    int imgWidth = wallTextureWidths[texId], imgHeight = wallTextureHeights[texId];
+
+    // Light level from distance and the tile the wall is seen from
+    int frontX = hitSide == 0 ? mapX - stepX : mapX;
+    int frontY = hitSide == 1 ? mapY - stepY : mapY;
+    int lightLevel = light.levelAt(correctedDistance, lightMap.get(frontX, frontY));
+
+    bool drawWall = true;
+    if (isDoor(tile)) {
+        drawWall = wallX > doorOpen;
+        wallX -= doorOpen;
+    }
+    if (drawWall) {
+        int texX = (int)(wallX * imgWidth);
+        if(hitSide == 0 && rayDirX > 0) texX = imgWidth - texX - 1;
+        if(hitSide == 1 && rayDirY < 0) texX = imgWidth - texX - 1;
+        texX = std::clamp(texX, 0, imgWidth - 1);
+
+        if (useFramebuffer) {
+            // Mip level from the projected height, far walls read small levels
+            const PixelTexture& base = wallPixels[texId];
+            const PixelTexture& tex = base.mip(base.mipLevelFor(lineHeight));
+            texX = texX * tex.width / base.width;
+            uint32_t* dst = frameBuffer.data() + ray;
+            for (int y = drawStart; y < drawEnd; y++) {
+                int texY = (int)((long long)(y - wallTop) * tex.height / lineHeight);
+                texY = std::clamp(texY, 0, tex.height - 1);
+                dst[y * screenW] = light.shade(tex.pixels[texY * tex.width + texX], lightLevel);
+            }
         }
+        else {
+            // Kept for renderWallQuads, which merges columns into quads
+            bool flip = (hitSide == 0 && rayDirX > 0) || (hitSide == 1 && rayDirY < 0);
+            float halfHeight = screenH / (2.0f * correctedDistance);
+            wallColumns[ray] = { texId, Map.index(mapX, mapY), hitSide, flip ? 1.0f - wallX : wallX,
+                                 screenH / 2 - halfHeight, screenH / 2 + halfHeight,
+                                 light.brightness(lightLevel) };
+        }
+    }
 
-        // Distance to wall = distance to side where hit happened
-        float distanceToWall;
-        if (hitSide == 0)
-            distanceToWall = sideDistX - deltaDistX;
-        else
-            distanceToWall = sideDistY - deltaDistY;
+    // The framebuffer path draws floor and ceiling as scanlines instead
+    if (useFramebuffer)
+        return;
 
-        float hitX = playerPosition.first  + rayDirX * distanceToWall;
-        float hitY = playerPosition.second + rayDirY * distanceToWall;
-        float wallX;
-        if (hitSide == 0)
-            wallX = hitY - floor(hitY);
-        else
-            wallX = hitX - floor(hitX);
-        float deltaAngle = rayAngle - playerAngle;
-        float correctedDistance = distanceToWall * cos(deltaAngle);
-        zBuffer[ray] = correctedDistance;
-
-        // Calculate wall height
-        int lineHeight = (int)(ScreenHeightWidth.second / correctedDistance);
-        int drawStart = -lineHeight / 2 + ScreenHeightWidth.second / 2;
-        int drawEnd   =  lineHeight / 2 + ScreenHeightWidth.second / 2;
-
-        if (drawStart < 0) drawStart = 0;
-        if (drawEnd >= ScreenHeightWidth.second) drawEnd = ScreenHeightWidth.second - 1;
-
-        // Wall Texture
-        int texId = Map[mapY][mapX] - 1;
-        int imgWidth = wallTextureWidths[texId], imgHeight = wallTextureHeights[texId];
-        SDL_QueryTexture(wallTextures[texId].get(), NULL, NULL, &imgWidth, &imgHeight);
-
-        // -------- distance-based shading --------
-        float maxLightDist = 8.0f;
-        float shade = 1.0f - std::min(correctedDistance / maxLightDist, 1.0f);
-        Uint8 brightness = (Uint8)(40 + shade * 215);
-        SDL_SetTextureColorMod(wallTextures[texId].get(),
-                            brightness, brightness, brightness);
-        // --------------------------------------
-
-        if(!isDoor(texId+1)){
-            int texX = (int)(wallX * imgWidth);
-            if(hitSide == 0 && rayDirX > 0) texX = imgWidth - texX - 1;
-            if(hitSide == 1 && rayDirY < 0) texX = imgWidth - texX - 1;
-            texX = std::clamp(texX, 0, imgWidth - 1);
-
-            SDL_Rect srcRect  = { texX, 0, 1, imgHeight };
-            SDL_Rect destRect = { ray, drawStart, 1, drawEnd - drawStart };
-            SDL_RenderCopy(renderer.get(), wallTextures[texId].get(), &srcRect, &destRect);
-        }
-        else if (wallX > doors[{mapY, mapX}].openAmount) {
-
-            wallX -= doors[{mapY, mapX}].openAmount;
-            int texX = (int)(wallX * imgWidth);
-            if(hitSide == 0 && rayDirX > 0) texX = imgWidth - texX - 1;
-            if(hitSide == 1 && rayDirY < 0) texX = imgWidth - texX - 1;
-            texX = std::clamp(texX, 0, imgWidth - 1);
-
-            SDL_Rect srcRect  = { texX, 0, 1, imgHeight };
-            SDL_Rect destRect = { ray, drawStart, 1, drawEnd - drawStart };
-            SDL_RenderCopy(renderer.get(), wallTextures[texId].get(), &srcRect, &destRect);
-        }
-
-        // Draw floor texture
-        if (floorTextures.size() > 0) {
-            int floorScreenStart = drawEnd; // start drawing floor below the wall
-            imgHeight = floorTextureHeights[0];
-            imgWidth = floorTextureWidths[0];
-            for (int y = drawEnd; y < ScreenHeightWidth.second; y++) {
-                float rowDist = playerHeight / ((float)y / ScreenHeightWidth.second - 0.5f);
-
-                // Interpolate floor coordinates
-                float floorX = playerPosition.first + rowDist * rayDirX;
-                float floorY = playerPosition.second + rowDist * rayDirY;
-
-                int texX = ((int)(floorX * imgWidth)) % imgWidth;
-                int texY = ((int)(floorY * imgHeight)) % imgHeight;
-
-                SDL_Rect srcRect  = { texX, texY, 1, 1 };
-                SDL_Rect destRect = { ray, y, 1, 1 };
-                SDL_RenderCopy(renderer.get(), floorTextures[0].get(), &srcRect, &destRect);
-            }
+    // Draw floor texture
+    if (floorTextures.size() > 0) {
+        for (int y = drawEnd; y < screenH; y++) {
+            float rowDist = rowDistance[y];
+
+            // Interpolate floor coordinates
+            float floorX = viewPosition.first + rowDist * rayDirX;
+            float floorY = viewPosition.second + rowDist * rayDirY;
+            int floorTex = layerTextureIndex(floorMap.get((int)floorf(floorX), (int)floorf(floorY)),
+                                             floorTextures.size());
+            imgWidth = floorTextureWidths[floorTex];
+            imgHeight = floorTextureHeights[floorTex];
+
+            int texX = ((int)(floorX * imgWidth)) % imgWidth;
+            int texY = ((int)(floorY * imgHeight)) % imgHeight;
+
+            SDL_Rect srcRect  = { texX, texY, 1, 1 };
+            SDL_Rect destRect = { ray, y, 1, 1 };
+            SDL_RenderCopy(renderer.get(), floorTextures[floorTex].get(), &srcRect, &destRect);
         }
-        
-        // Draw ceiling
+    }
+    
+    // Draw ceiling
+    if (ceilingTextures.size() > 0) {
         for(int y = 0; y < drawStart; y++) {
-            if(ceilingTextures.size() > 0) {
-                int imgWidth = ceilingTextureWidths[0];
-                int imgHeight = ceilingTextureHeights[0];
+            float rowDist = rowDistance[y];
+
+            // Interpolate ceiling coordinates
+            float ceilX = viewPosition.first + rowDist * rayDirX;
+            float ceilY = viewPosition.second + rowDist * rayDirY;
+            int ceilTex = layerTextureIndex(ceilingMap.get((int)floorf(ceilX), (int)floorf(ceilY)),
+                                            ceilingTextures.size());
+            imgWidth = ceilingTextureWidths[ceilTex];
+            imgHeight = ceilingTextureHeights[ceilTex];
+
+            int texX = ((int)(ceilX * imgWidth)) % imgWidth;
+            int texY = ((int)(ceilY * imgHeight)) % imgHeight;
+
+            SDL_Rect srcRect  = { texX, texY, 1, 1 };
+            SDL_Rect destRect = { ray, y, 1, 1 };
+            SDL_RenderCopy(renderer.get(), ceilingTextures[ceilTex].get(), &srcRect, &destRect);
+        } 
+    }
+}
 
-                float rowDist = playerHeight / (0.5f - (float)y / ScreenHeightWidth.second);
+// Draws columns [begin, end) of a sprite, all of them in front of the walls
+void Game::drawSpriteRun(const SpriteRecord& sprite, int begin, int end)
+{
+    int screenW = ScreenHeightWidth.first, screenH = ScreenHeightWidth.second;
+    const AtlasRect& rect = enemyAtlasRects[sprite.slot];
+
+    if (!useFramebuffer) {
+        // One quad of the batch, shaded through its vertex colour
+        float u0 = (rect.x + (float)(begin - sprite.left) * rect.w / sprite.width) / enemyAtlas.width;
+        float u1 = (rect.x + (float)(end - sprite.left) * rect.w / sprite.width) / enemyAtlas.width;
+        float v0 = (float)rect.y / enemyAtlas.height;
+        float v1 = (float)(rect.y + rect.h) / enemyAtlas.height;
+        float top = (float)sprite.top, bottom = (float)(sprite.top + sprite.height);
+        Uint8 brightness = light.brightness(sprite.lightLevel);
+        SDL_Color colour = { brightness, brightness, brightness, 255 };
+
+        int base = (int)spriteVertices.size();
+        spriteVertices.push_back({ {(float)begin, top},    colour, {u0, v0} });
+        spriteVertices.push_back({ {(float)end,   top},    colour, {u1, v0} });
+        spriteVertices.push_back({ {(float)end,   bottom}, colour, {u1, v1} });
+        spriteVertices.push_back({ {(float)begin, bottom}, colour, {u0, v1} });
+        for (int i : {0, 1, 2, 0, 2, 3})
+            spriteIndices.push_back(base + i);
+        return;
+    }
 
-                // Interpolate ceiling coordinates
-                float ceilX = playerPosition.first + rowDist * rayDirX;
-                float ceilY = playerPosition.second + rowDist * rayDirY;
+    // Smallest atlas level whose frame is still as tall as the sprite
+    int level = 0;
+    while (level < (int)enemyAtlasMipRects.size() && enemyAtlasMipRects[level][sprite.slot].h >= sprite.height)
+        level++;
+    const PixelTexture& atlas = enemyAtlas.mip(level);
+    const AtlasRect& mipRect = level > 0 ? enemyAtlasMipRects[level - 1][sprite.slot] : rect;
+    int texW = mipRect.w, texH = mipRect.h;
+
+    int drawStartY = std::max(sprite.top, 0);
+    int drawEndY = std::min(sprite.height / 2 + screenH / 2, screenH - 1);
+    for (int x = begin; x < end; x++) {
+        int texX = (x - sprite.left) * texW / sprite.width;
+
+        // Alpha-tested: fully transparent texels are skipped
+        const uint32_t* column = atlas.pixels.data() + mipRect.y * atlas.width + mipRect.x + texX;
+        for (int y = drawStartY; y < drawEndY; y++) {
+            int texY = (int)((long long)(y - sprite.top) * texH / sprite.height);
+            uint32_t texel = column[std::min(texY, texH - 1) * atlas.width];
+            if ((texel >> 24) == 0)
+                continue;
+            frameBuffer[y * screenW + x] = light.shade(texel, sprite.lightLevel);
+        }
+    }
+}
 
-                int texX = ((int)(ceilX * imgWidth)) % imgWidth;
-                int texY = ((int)(ceilY * imgHeight)) % imgHeight;
+// Index of the enemy under the crosshair within shooting range (the
+// nearest one if several overlap), or -1. Only enemies in cells around
+// the player are projected. Aimed from the tick's position and angle and
+// projected at the setResolution size, so a shot lands the same at any
+// frame rate or render scale.
+int Game::findShotTarget() const
+{
+    const float maxShotDist = 5.0f;
+    float screenW = (float)displaySize.first, screenH = (float)displaySize.second;
+    float px = playerPosition.first, py = playerPosition.second;
+    float dirX = cos(playerAngle), dirY = sin(playerAngle);
+    float planeScale = tan(FOV * (3.14159f / 180.0f) / 2.0f);
+
+    int target = -1;
+    float targetDist = maxShotDist;
+    enemyGrid.forEachInBox(px - maxShotDist, py - maxShotDist, px + maxShotDist, py + maxShotDist, [&](int id) {
+        float dx = enemies.position(id).first - px;
+        float dy = enemies.position(id).second - py;
+        float enemyDist = sqrt(dx*dx + dy*dy);
+        float depth = dx * dirX + dy * dirY;
+        if (enemyDist >= targetDist || depth <= 0.0f)
+            return;
+        // Camera plane position, -1..1 across the screen
+        float cameraX = (dy * dirX - dx * dirY) / (planeScale * depth);
+        if (fabs(cameraX) > 1.0f)
+            return;
+        // The sprite is screenH / enemyDist wide around its screen column
+        if (fabs(cameraX) * screenW / 2 <= screenH / enemyDist / 2) {
+            target = id;
+            targetDist = enemyDist;
+        }
+    });
+    return target;
+}
 
-                SDL_Rect srcRect  = { texX, texY, 1, 1 };
-                SDL_Rect destRect = { ray, y, 1, 1 };
-                SDL_RenderCopy(renderer.get(), ceilingTextures[0].get(), &srcRect, &destRect);
-            } 
+// Pixels from world position p, moving by step per pixel, that stay in the
+// tile starting at floor(p); at least 1 and at most limit
+static int pixelsInTile(float p, float step, int limit)
+{
+    float tile = floorf(p), run;
+    if (step > 0.0f)
+        run = ceilf((tile + 1.0f - p) / step);
+    else if (step < 0.0f)
+        run = floorf((tile - p) / step) + 1.0f;
+    else
+        return limit;
+    return (int)std::clamp(run, 1.0f, (float)limit);
+}
+
+void Game::renderFloorAndCeilingRows(int rowBegin, int rowEnd)
+{
+    int screenW = ScreenHeightWidth.first, screenH = ScreenHeightWidth.second;
+
+    for (int y = rowBegin; y < rowEnd; y++) {
+        // The horizon row is at infinite distance, the wall always covers it
+        if (y == screenH / 2)
+            continue;
+        bool isFloor = y > screenH / 2;
+        const std::vector<PixelTexture>& textures = isFloor ? floorPixels : ceilingPixels;
+        const TileGrid& layer = isFloor ? floorMap : ceilingMap;
+        if (textures.empty())
+            continue;
+
+        // Every pixel of a row lies at the same perpendicular distance, so
+        // the world position moves linearly from the left ray to the right one
+        float rowDist = rowDistance[y];
+        float worldX = viewPosition.first  + rowDist * (viewDirX - viewPlaneX);
+        float worldY = viewPosition.second + rowDist * (viewDirY - viewPlaneY);
+        float stepX = rowDist * 2.0f * viewPlaneX / screenW;
+        float stepY = rowDist * 2.0f * viewPlaneY / screenW;
+
+        // One span per tile the row crosses, the layers are read once per
+        // span and the whole span is shaded at that tile's light level
+        uint32_t* dst = frameBuffer.data() + y * screenW;
+        for (int x = 0; x < screenW; ) {
+            float spanX = worldX + x * stepX, spanY = worldY + x * stepY;
+            int run = pixelsInTile(spanX, stepX, screenW - x);
+            run = pixelsInTile(spanY, stepY, run);
+            int tileX = (int)floorf(spanX), tileY = (int)floorf(spanY);
+            TileGrid::Tile tile = layer.get(tileX, tileY);
+            drawTexturedSpan(dst + x, run, textures[layerTextureIndex(tile, textures.size())],
+                             spanX, spanY, stepX, stepY);
+            light.shadeSpan(dst + x, run, light.levelAt(rowDist, lightMap.get(tileX, tileY)));
+            x += run;
         }
     }
-    // Rendering Enemy
-    std::sort(enemies.begin(), enemies.end(),
-        [&](const std::unique_ptr<Enemy>& e1,
-            const std::unique_ptr<Enemy>& e2)
-        {
-            float d1 = distSq(playerPosition, e1->get_position());
-            float d2 = distSq(playerPosition, e2->get_position());
-            return d1 > d2;   // '>' → farthest first
-        });
-    int enemyShotIndex = -1, currentIndex = 0;
-    for (const auto& enemy : enemies) 
+}
+
+// Columns per zBlockMax entry
+static constexpr int Z_BLOCK = 16;
+
+void Game::renderEnemies()
+{
+    int screenW = ScreenHeightWidth.first, screenH = ScreenHeightWidth.second;
+
+    // Rendering Enemy. The draw order holds enemy ids, enemies itself is
+    // never reordered (enemyGrid stores its indices). It is kept from the
+    // last frame and insertion sorted: distances barely change between
+    // frames, so that is close to one pass.
     {
-        // Enemy position relative to player 
-        auto [ex, ey] = enemy->get_position();
+        ProfileScope scope(profiler, PROFILE_SPRITE_SORT);
+        int count = enemies.count();
+        if ((int)drawOrder.size() != count) {
+            drawOrder.resize(count);
+            for (int i = 0; i < count; i++)
+                drawOrder[i] = i;
+        }
+        spriteDistSq.resize(count);
+        for (int i = 0; i < count; i++)
+            spriteDistSq[i] = distSq(viewPosition, enemies.interpolatedPosition(i, renderAlpha));
+        for (int i = 1; i < count; i++) {
+            int enemy = drawOrder[i];
+            int j = i;
+            for (; j > 0 && spriteDistSq[drawOrder[j - 1]] < spriteDistSq[enemy]; j--)   // farthest first
+                drawOrder[j] = drawOrder[j - 1];
+            drawOrder[j] = enemy;
+        }
+    }
+    ProfileScope scope(profiler, PROFILE_SPRITE_DRAW);
 
-        float dx = ex - playerPosition.first;
-        float dy = ey - playerPosition.second;
+    // Farthest wall in each block of columns. A sprite at least that far
+    // away in every block it covers is entirely behind walls.
+    zBlockMax.assign((screenW + Z_BLOCK - 1) / Z_BLOCK, 0.0f);
+    for (int x = 0; x < screenW; x++)
+        zBlockMax[x / Z_BLOCK] = std::max(zBlockMax[x / Z_BLOCK], zBuffer[x]);
 
-        float enemyDist = sqrt(dx*dx + dy*dy);
+    // Project and cull into draw records, in draw order
+    spriteRecords.clear();
+    for (int enemy : drawOrder) 
+    {
+        // Enemy position relative to player; enemies on tiles the wall
+        // pass never reached are not projected at all
+        auto [ex, ey] = enemies.interpolatedPosition(enemy, renderAlpha);
+        if (!areaSeen(ex, ey))
+            continue;
 
-        // Angle between player view and enemy 
-        float enemyAngle = atan2(dy, dx) - playerAngle;
+        float dx = ex - viewPosition.first;
+        float dy = ey - viewPosition.second;
 
-        while (enemyAngle > PI)  enemyAngle -= 2 * PI;
-        while (enemyAngle < -PI) enemyAngle += 2 * PI;
+        float enemyDist = sqrt(dx*dx + dy*dy);
+
+        // Enemy in camera space: depth along the view direction and
+        // position on the camera plane, -1..1 across the screen
+        float depth = dx * viewDirX + dy * viewDirY;
+        float cameraX = (dx * viewPlaneX + dy * viewPlaneY) /
+                        (viewPlaneScale * viewPlaneScale * depth);
 
         // Check if enemy is inside FOV 
-        if (fabs(enemyAngle) > halfFov){
+        if (depth <= 0.0f || fabs(cameraX) > 1.0f){
             //std::cout<<"enemy out of FOV\n";
             continue; 
         }
-        // Project enemy into screen space
+        // Project enemy onto the camera plane
         int screenX = (int)(
-            (enemyAngle + halfFov) / fovRad * ScreenHeightWidth.first
+            (1.0f + cameraX) * screenW / 2
         );
 
         // Perspective scaling 
-        int spriteHeight = (int)(ScreenHeightWidth.second / enemyDist);
-        int spriteWidth  = spriteHeight;
-
-        int drawStartY = -spriteHeight / 2 + ScreenHeightWidth.second / 2;
-        int drawEndY   =  spriteHeight / 2 + ScreenHeightWidth.second / 2;
-
-        if (drawStartY < 0) drawStartY = 0;
-        if (drawEndY >= ScreenHeightWidth.second)
-            drawEndY = ScreenHeightWidth.second - 1;
-
-        int drawStartX = -spriteWidth / 2 + screenX;
-        int drawEndX   =  spriteWidth / 2 + screenX;
-        int screenCentreX = ScreenHeightWidth.first / 2;
-        if(shotThisFrame &&
-           screenX >= screenCentreX - spriteWidth / 2 &&
-           screenX <= screenCentreX + spriteWidth / 2 &&
-           enemyDist < 5.0f) 
-        {
-            enemyShotIndex = currentIndex;
-        }
-        // Select enemy texture 
-        if (enemyTextures.empty()){
-            //std::cout<<"0 elements in enemyTextures\n";
+        SpriteRecord sprite;
+        sprite.dist = enemyDist;
+        sprite.height = (int)(screenH / enemyDist);
+        sprite.width  = sprite.height;
+        sprite.top = -sprite.height / 2 + screenH / 2;
+        sprite.left = -sprite.width / 2 + screenX;
+        sprite.beginX = std::max(sprite.left, 0);
+        sprite.endX = std::min(sprite.width / 2 + screenX, screenW);
+        if (sprite.beginX >= sprite.endX)
             continue;
-        }
-        int frame = enemy->get_current_frame(), dir = enemy->get_dirn_num();
-        auto it = enemyTextures.find({frame, dir});
-        if (it == enemyTextures.end()) continue;
-        SDL_Texture* tex = it->second.get();
-
-        // distance-based shading 
-        float maxLightDist = 8.0f;
-        float shade = 1.0f - std::min(enemyDist / maxLightDist, 1.0f);
-        Uint8 brightness = (Uint8)(40 + shade * 215);
-        SDL_SetTextureColorMod(tex,
-                            brightness, brightness, brightness);
-        
-        int texW, texH;
-        SDL_QueryTexture(tex, nullptr, nullptr, &texW, &texH);
-
-        // Draw sprite column-by-column
-        for (int x = drawStartX; x < drawEndX; x++)
-        {
-            if (x < 0 || x >= ScreenHeightWidth.first)
-                continue;
 
-            // Z-buffer check (VERY IMPORTANT) 
-            if (enemyDist >= zBuffer[x])
-                continue; 
+        // Occlusion: skip sprites whose whole span is behind walls
+        bool visible = false;
+        for (int block = sprite.beginX / Z_BLOCK; block <= (sprite.endX - 1) / Z_BLOCK && !visible; block++)
+            visible = enemyDist < zBlockMax[block];
+        if (!visible)
+            continue;
 
-            int texX = (int)(
-                (x - drawStartX) * texW / spriteWidth
-            );
+        // Select enemy frame in the atlas
+        sprite.slot = enemyFrameSlot(enemies.currentFrame(enemy),
+                                     enemies.direction(enemy, viewPosition.first, viewPosition.second));
+        if (sprite.slot < 0) continue;
 
-            SDL_Rect srcRect = { texX, 0, 1, texH };
-            SDL_Rect dstRect = {
-                x,
-                drawStartY,
-                1,
-                drawEndY - drawStartY
-            };
+        // Light level from distance and the tile the enemy stands on
+        sprite.lightLevel = light.levelAt(enemyDist, lightMap.get((int)floorf(ex), (int)floorf(ey)));
+        spriteRecords.push_back(sprite);
+    }
 
-            SDL_RenderCopy(renderer.get(), tex, &srcRect, &dstRect);
+    // Draw each sprite in the runs of columns where it is in front of the
+    // walls; whole blocks of hidden columns are skipped at once
+    spriteVertices.clear();
+    spriteIndices.clear();
+    for (const SpriteRecord& sprite : spriteRecords) {
+        int x = sprite.beginX;
+        while (x < sprite.endX) {
+            while (x < sprite.endX && sprite.dist >= zBuffer[x]) {
+                if (x % Z_BLOCK == 0 && sprite.dist >= zBlockMax[x / Z_BLOCK])
+                    x += Z_BLOCK;
+                else
+                    x++;
+            }
+            int runBegin = std::min(x, sprite.endX);
+            while (x < sprite.endX && sprite.dist < zBuffer[x])
+                x++;
+            if (x > runBegin)
+                drawSpriteRun(sprite, runBegin, x);
         }
-        currentIndex++;
-    }
-    if (enemyShotIndex != -1) {
-        float dist = distSq(
-            playerPosition,
-            enemies[enemyShotIndex]->get_position()
-        );
-        dist = pow(dist, 0.5f); // sqrt
-        int dmg=0;
-        if(canShootEnemy(dist))
-            dmg = (rand() & 31) * weaponMultiplier;
-        //std::cout << "Enemy at index " << enemyShotIndex << " shot for " << dmg << " damage.\n";
-        if (rayCastEnemyToPlayer(*enemies[enemyShotIndex]))
-            enemies[enemyShotIndex]->takeDamage(dmg); 
-        shotThisFrame = false;
-    }
-    else if (shotThisFrame) {
-        shotThisFrame = false;
     }
-    SDL_RenderPresent(renderer.get()); 
+
+    // Every visible sprite span goes to the GPU in a single call
+    if (!spriteIndices.empty())
+        SDL_RenderGeometry(renderer.get(), enemyAtlasTexture.get(),
+                           spriteVertices.data(), (int)spriteVertices.size(),
+                           spriteIndices.data(), (int)spriteIndices.size());
 }
-void Game::loadMapDataFromFile(const char* filename)
+// Ragged text rows as width-wide rows of tiles, short rows padded with 0,
+// so the chunked grids are filled in one pass
+static std::vector<TileGrid::Tile> flattenRows(const std::vector<std::vector<int>>& rows, size_t width)
 {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open map data file: " << filename << std::endl;
+    std::vector<TileGrid::Tile> tiles(rows.size() * width, 0);
+    for (size_t y = 0; y < rows.size(); y++)
+        for (size_t x = 0; x < rows[y].size(); x++)
+            tiles[y * width + x] = (TileGrid::Tile)rows[y][x];
+    return tiles;
+}
+
+void Game::loadMapDataFromFile(const char* filename, const char* floorFile, const char* ceilingFile,
+                               const char* lightFile)
+{
+    // Rows can be ragged; the grid is as wide as the longest one and
+    // missing tiles stay empty inside the border
+    std::vector<std::vector<int>> rows;
+    if (!readTextLayer(filename, rows))
         return;
-    }
-    Map.clear();
-    std::string line;
-    while (std::getline(file, line)) {
-        std::vector<int> row; 
-        for (char& ch : line) {
-            if (ch >= '6' && ch <= '9') {
-                int t = ch - '0';
-                Door d;
-                d.openAmount = 0.0f;
-                d.opening = false;
-                if (t == 6) { d.locked = false; d.keyType = 0; }
-                if (t == 7) { d.locked = true;  d.keyType = 1; }  // blue key
-                if (t == 8) { d.locked = true;  d.keyType = 2; }  // red key
-                if (t == 9) { d.locked = true;  d.keyType = 3; }  // gold key
-                
-                doors[{Map.size(), row.size()}] = d;
-            }
-            if (ch >= '0' && ch <= '9') {
-                row.push_back(ch - '0');
-            }
+    size_t width = 0;
+    for (const std::vector<int>& row : rows)
+        width = std::max(width, row.size());
+
+    Map.resize((int)width, (int)rows.size());
+    Map.assignRows(flattenRows(rows, width).data());
+    doors.clear();
+    for (size_t y = 0; y < rows.size(); y++)
+        for (size_t x = 0; x < rows[y].size(); x++) {
+            LevelDoor door;
+            if (doorFromTile(rows[y][x], (int)x, (int)y, door))
+                addDoor(door);
         }
-        Map.push_back(row);
+    rebuildEnemyGrid();
+
+    // mapEditor.py saves the layers as floor.txt / ceil.txt next to map.txt,
+    // light.txt is hand-written in the same format
+    std::string path = filename;
+    size_t slash = path.find_last_of("/\\");
+    std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    loadTileLayer(floorMap, floorFile ? floorFile : (dir + "floor.txt").c_str(), floorFile != nullptr);
+    loadTileLayer(ceilingMap, ceilingFile ? ceilingFile : (dir + "ceil.txt").c_str(), ceilingFile != nullptr);
+    loadTileLayer(lightMap, lightFile ? lightFile : (dir + "light.txt").c_str(), lightFile != nullptr);
+
+    wallDistance.build(Map);
+    Uint64 pvsStart = SDL_GetPerformanceCounter();
+    pvs.build(Map, workers);
+    std::cout << "PVS: " << Map.width() << "x" << Map.height() << " tiles, "
+              << pvs.uniqueSetCount() << " unique sets, "
+              << (SDL_GetPerformanceCounter() - pvsStart) * 1000.0 / SDL_GetPerformanceFrequency()
+              << " ms\n";
+}
+
+// Floor/ceiling layer for the current Map. A missing optional file or one
+// whose size differs from the map leaves the layer all 0 (first texture).
+void Game::loadTileLayer(TileGrid& layer, const char* filename, bool required)
+{
+    layer.resize(Map.width(), Map.height());
+    if (!required && !std::ifstream(filename).good())
+        return;
+    std::vector<std::vector<int>> rows;
+    if (!readTextLayer(filename, rows))
+        return;
+    size_t width = 0;
+    for (const std::vector<int>& row : rows)
+        width = std::max(width, row.size());
+    if ((int)width != Map.width() || (int)rows.size() != Map.height()) {
+        std::cerr << "Ignoring " << filename << ": " << width << "x" << rows.size()
+                  << " does not match the " << Map.width() << "x" << Map.height() << " map\n";
+        return;
     }
+    layer.assignRows(flattenRows(rows, width).data());
+}
+
+bool Game::loadLevel(const char* filename)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    MappedLevel level;
+    if (!level.open(filename))
+        return false;
+    const LevelHeader& h = level.header();
+
+    // Layers are stored as TileGrid tiles already; assignRows only keeps
+    // chunks that are not all one tile
+    Map.resize(h.width, h.height);
+    floorMap.resize(h.width, h.height);
+    ceilingMap.resize(h.width, h.height);
+    lightMap.resize(h.width, h.height);
+    Map.assignRows(level.walls());
+    floorMap.assignRows(level.floors());
+    ceilingMap.assignRows(level.ceilings());
+    lightMap.assignRows(level.lights());
+
+    doors.clear();
+    for (uint32_t i = 0; i < h.doorCount; i++)
+        addDoor(level.doors()[i]);
+
+    enemies.clear();
+    for (uint32_t i = 0; i < h.enemyCount; i++)
+        addEnemy(level.enemies()[i].x, level.enemies()[i].y, level.enemies()[i].angle);
+    rebuildEnemyGrid();
+
+    playerPosition = {h.playerX, h.playerY};
+    prevPlayerPosition = playerPosition;
+    playerAngle = h.playerAngle;
+    lastTickTurn = 0.0f;
+
+    wallDistance.build(Map);
+    if (level.hasPvs())
+        pvs.assign(h.width, h.height, level.pvsTileSets(), level.pvsSets(), h.pvsSetCount);
+    else
+        pvs.build(Map, workers);
+
+    size_t chunkKb = (Map.chunkBytes() + floorMap.chunkBytes() + ceilingMap.chunkBytes() +
+                      lightMap.chunkBytes()) / 1024;
+    std::cout << "Level " << filename << ": " << h.width << "x" << h.height << ", "
+              << h.doorCount << " doors, " << h.enemyCount << " enemies, "
+              << chunkKb << " KB of tile chunks, loaded in "
+              << (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency()
+              << " ms\n";
+    return true;
+}
+
+void Game::addDoor(const LevelDoor& door)
+{
+    Door d;
+    d.openAmount = 0.0f;
+    d.opening = false;
+    d.locked = door.locked;
+    d.keyType = door.keyType;
+    d.x = door.x;
+    d.y = door.y;
+    doors.push_back(d);
+    Map.setDoor(door.x, door.y, (int)doors.size() - 1);
 }
 void Game::placePlayerAt(int x, int y, float angle) {
     playerPosition = {static_cast<double>(x), static_cast<double>(y)};
+    prevPlayerPosition = playerPosition;
     playerAngle = angle;
+    lastTickTurn = 0.0f;
 }
-void Game::addWallTexture(const char* filePath)
+// Decodes an image file to ARGB8888 pixels for the framebuffer renderer.
+static bool decodeImage(const char* filePath, PixelTexture& pixels)
 {
-    SDL_Texture* raw = IMG_LoadTexture(renderer.get(), filePath);
-    if (!raw) {
-        std::cerr << "Failed to load wall texture: "
-                  << filePath << " | " << IMG_GetError() << "\n";
-        return;
+    SDL_Surface* loaded = IMG_Load(filePath);
+    if (!loaded)
+        return false;
+    SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loaded);
+    if (!surface)
+        return false;
+
+    pixels.width  = surface->w;
+    pixels.height = surface->h;
+    pixels.pixels.resize((size_t)surface->w * surface->h);
+    SDL_LockSurface(surface);
+    for (int y = 0; y < surface->h; y++) {
+        const uint32_t* row = reinterpret_cast<const uint32_t*>(
+            static_cast<const uint8_t*>(surface->pixels) + y * surface->pitch);
+        std::copy(row, row + surface->w, pixels.pixels.begin() + (size_t)y * surface->w);
     }
+    SDL_UnlockSurface(surface);
+    SDL_FreeSurface(surface);
+    return true;
+}
+
+// Uploads decoded pixels as an alpha-blended texture for the SDL_Renderer path.
+static SDL_Texture* createTextureFromPixels(SDL_Renderer* renderer, const PixelTexture& pixels)
+{
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                             SDL_TEXTUREACCESS_STATIC, pixels.width, pixels.height);
+    if (!texture)
+        return nullptr;
+    SDL_UpdateTexture(texture, nullptr, pixels.pixels.data(), pixels.width * (int)sizeof(uint32_t));
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
+
+static double elapsedMs(Uint64 start)
+{
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// One image of a texture list. Decoding runs on the worker pool; errors
+// are kept here and printed by the main thread in list order.
+struct DecodedImage {
+    std::string path;
+    PixelTexture pixels;
+    bool ok = false;
+    std::string error;
+    double decodeMs = 0.0, uploadMs = 0.0;
+};
 
-    wallTextures.emplace_back(raw, SDL_DestroyTexture);
+// Decodes every image across the pool, one image per band so large and
+// small files balance out. Returns the wall-clock time of the batch.
+static double decodeImages(WorkerPool& workers, std::vector<DecodedImage>& images)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    workers.parallelFor((int)images.size(), 1, [&images](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            DecodedImage& image = images[i];
+            Uint64 imageStart = SDL_GetPerformanceCounter();
+            image.ok = decodeImage(image.path.c_str(), image.pixels);
+            if (!image.ok)
+                image.error = IMG_GetError();   // SDL errors are per thread
+            image.decodeMs = elapsedMs(imageStart);
+        }
+    });
+    return elapsedMs(start);
+}
 
-    int width = 0, height = 0;
-    if (SDL_QueryTexture(raw, nullptr, nullptr, &width, &height) != 0) {
-        std::cerr << "Failed to query texture: "
-                  << SDL_GetError() << "\n";
-        wallTextures.pop_back();   // keep vectors in sync
+// Startup report: totals always, decode/upload per asset when asked
+static void reportAssetTimings(const char* listPath, const std::vector<DecodedImage>& images,
+                               double decodeMs, double uploadMs, int threads, bool perAsset)
+{
+    double decodeSum = 0.0;
+    for (const DecodedImage& image : images)
+        decodeSum += image.decodeMs;
+    std::cout << "Assets " << listPath << ": " << images.size() << " images, decode "
+              << decodeMs << " ms on " << threads << " threads (" << decodeSum
+              << " ms serial), upload " << uploadMs << " ms\n";
+    if (!perAsset)
         return;
-    }
+    for (const DecodedImage& image : images)
+        std::cout << "  decode " << image.decodeMs << " ms  upload " << image.uploadMs
+                  << " ms  " << image.path << (image.ok ? "" : "  (failed)") << "\n";
+}
 
-    wallTextureWidths.push_back(width);
-    wallTextureHeights.push_back(height);
+void Game::addWallTexture(const char* filePath)
+{
+    PixelTexture pixels;
+    if (!decodeImage(filePath, pixels) || !addTexture(WALL_LAYER, pixels)) {
+        std::cerr << "Failed to load wall texture: "
+                  << filePath << " | " << IMG_GetError() << "\n";
+    }
 }
 
 void Game::addFloorTexture(const char* filePath) {
-    SDL_Texture* raw = IMG_LoadTexture(renderer.get(), filePath);
-    if (!raw) {
+    PixelTexture pixels;
+    if (!decodeImage(filePath, pixels) || !addTexture(FLOOR_LAYER, pixels)) {
         std::cerr << "Failed to load floor texture: "
                   << filePath << " | " << IMG_GetError() << "\n";
-        return;
     }
-
-    floorTextures.emplace_back(raw, SDL_DestroyTexture);
-
-    int width = 0, height = 0;
-    if (SDL_QueryTexture(raw, nullptr, nullptr, &width, &height) != 0) {
-        std::cerr << "Failed to query texture: "
-                  << SDL_GetError() << "\n";
-        floorTextures.pop_back();   // keep vectors in sync
-        return;
-    }
-
-    floorTextureWidths.push_back(width);
-    floorTextureHeights.push_back(height);
 }
 void Game::addCeilingTexture(const char* filePath) {
-    SDL_Texture* raw = IMG_LoadTexture(renderer.get(), filePath);
-    if (!raw) {
+    PixelTexture pixels;
+    if (!decodeImage(filePath, pixels) || !addTexture(CEILING_LAYER, pixels)) {
         std::cerr << "Failed to load ceiling texture: "
                   << filePath << " | " << IMG_GetError() << "\n";
-        return;
-    }
-
-    ceilingTextures.emplace_back(raw, SDL_DestroyTexture);
-
-    int width = 0, height = 0;
-    if (SDL_QueryTexture(raw, nullptr, nullptr, &width, &height) != 0) {
-        std::cerr << "Failed to query texture: "
-                  << SDL_GetError() << "\n";
-        ceilingTextures.pop_back();   // keep vectors in sync
-        return;
     }
+}
 
-    ceilingTextureWidths.push_back(width);
-    ceilingTextureHeights.push_back(height);
+// Creates the SDL texture for decoded pixels and appends both to a layer.
+// Main thread only: the renderer is not thread safe.
+bool Game::addTexture(TextureLayer layer, PixelTexture& pixels)
+{
+    SDL_Texture* raw = createTextureFromPixels(renderer.get(), pixels);
+    if (!raw)
+        return false;
+
+    std::vector<SDLTexturePtr>& textures =
+        layer == WALL_LAYER ? wallTextures : layer == FLOOR_LAYER ? floorTextures : ceilingTextures;
+    std::vector<int>& widths =
+        layer == WALL_LAYER ? wallTextureWidths : layer == FLOOR_LAYER ? floorTextureWidths : ceilingTextureWidths;
+    std::vector<int>& heights =
+        layer == WALL_LAYER ? wallTextureHeights : layer == FLOOR_LAYER ? floorTextureHeights : ceilingTextureHeights;
+    std::vector<PixelTexture>& layerPixels =
+        layer == WALL_LAYER ? wallPixels : layer == FLOOR_LAYER ? floorPixels : ceilingPixels;
+
+    // Walls are sampled as columns of any height, sprites get theirs per frame
+    if (layer == WALL_LAYER)
+        pixels.buildMips();
+
+    textures.emplace_back(raw, SDL_DestroyTexture);
+    widths.push_back(pixels.width);
+    heights.push_back(pixels.height);
+    layerPixels.push_back(std::move(pixels));
+    return true;
 }
 
 void Game::printPlayerPosition(){
@@ -689,6 +1522,46 @@ bool Game::playerHasKey(int keyType) {
     }
     return false;
 }
+Game::Door* Game::doorAt(int x, int y) {
+    int door = Map.doorAt(x, y);
+    return door >= 0 ? &doors[door] : nullptr;
+}
+const Game::Door* Game::doorAt(int x, int y) const {
+    int door = Map.doorAt(x, y);
+    return door >= 0 ? &doors[door] : nullptr;
+}
+bool Game::doorBlocks(int x, int y) const {
+    return doorBlocks(Map.doorAt(x, y));
+}
+float Game::doorOpenAmount(int door) const {
+    return door >= 0 ? doors[door].openAmount : 0.0f;
+}
+bool Game::doorBlocks(int door) const {
+    return doorOpenAmount(door) <= 0.5f;
+}
+void Game::tryOpenDoor(int x, int y) {
+    Door* d = doorAt(x, y);
+    if (!d)
+        return;
+    if (d->locked && !playerHasKey(d->keyType))
+        return;
+    if (d->openAmount == 0.0f)
+        d->opening = true;
+}
+void Game::updateDoors(float deltaTime) {
+    for (Door& d : doors)
+    {
+        if (d.opening) {
+            d.openAmount += 1.5f * deltaTime;
+            if (d.openAmount >= 1.0f) {
+                d.openAmount = 1.0f;
+                d.opening = false;
+                // Fully open doors let every ray through, so rays may skip them
+                wallDistance.setSolid(d.x, d.y, false);
+            }
+        }
+    }
+}
 static std::string toLower(const std::string &s) {
     std::string r = s;
     std::transform(r.begin(), r.end(), r.begin(),
@@ -706,6 +1579,10 @@ void Game::loadAllTextures(const char* filePath)
     enum Section { NONE, WALLS, FLOORS, CEILS };
     Section currentSection = NONE;
 
+    // Collect the list first so every image can be decoded in parallel
+    std::vector<DecodedImage> images;
+    std::vector<TextureLayer> layers;
+
     std::string line;
     while (std::getline(file, line)) {
 
@@ -734,28 +1611,46 @@ void Game::loadAllTextures(const char* filePath)
         }
 
         // If it’s not a section header, it must be a file path
-        if (currentSection == WALLS) {
-            addWallTexture(line.c_str());
-        }
-        else if (currentSection == FLOORS) {
-            addFloorTexture(line.c_str());
-        }
-        else if (currentSection == CEILS) {
-            addCeilingTexture(line.c_str());
-        }
-        else {
+        if (currentSection == NONE) {
             std::cerr << "Warning: Path found outside any valid section: " << line << "\n";
+            continue;
+        }
+        images.emplace_back();
+        images.back().path = line;
+        layers.push_back(currentSection == WALLS ? WALL_LAYER
+                         : currentSection == FLOORS ? FLOOR_LAYER : CEILING_LAYER);
+    }
+
+    double decodeMs = decodeImages(workers, images);
+
+    // Upload in list order, texture ids are the order within each section
+    static const char* const layerNames[] = { "wall", "floor", "ceiling" };
+    Uint64 uploadStart = SDL_GetPerformanceCounter();
+    for (size_t i = 0; i < images.size(); i++) {
+        DecodedImage& image = images[i];
+        Uint64 imageStart = SDL_GetPerformanceCounter();
+        if (image.ok && !addTexture(layers[i], image.pixels)) {
+            image.ok = false;
+            image.error = SDL_GetError();
         }
+        image.uploadMs = elapsedMs(imageStart);
+        if (!image.ok)
+            std::cerr << "Failed to load " << layerNames[layers[i]] << " texture: "
+                      << image.path << " | " << image.error << "\n";
     }
+    reportAssetTimings(filePath, images, decodeMs, elapsedMs(uploadStart),
+                       workers.threadCount(), assetTimingReport);
 }
 void Game::clean()
 {
-    enemyTextures.clear();
+    enemyAtlasTexture.reset();
     wallTextures.clear();
     floorTextures.clear();
     ceilingTextures.clear();
+    frameTexture.reset();
     doors.clear();
     enemies.clear();
+    enemyGrid.reset(Map.width(), Map.height());
 
     renderer.reset();
     window.reset();
@@ -773,6 +1668,9 @@ void Game::loadEnemyTextures(const char* filePath)
         return;
     }
 
+    struct Frame { int frame, dir; };
+    std::vector<Frame> frames;
+    std::vector<DecodedImage> images;
     std::string line;
 
     while (std::getline(file, line)) {
@@ -793,23 +1691,96 @@ void Game::loadEnemyTextures(const char* filePath)
 
         // Expect: <int> <int> <string>
         if (iss >> a >> b >> path) {
-            SDL_Texture* texture = IMG_LoadTexture(renderer.get(), path.c_str());
-            if (!texture) {
-                std::cerr << "Failed to load texture: " << filePath << " Error: " << IMG_GetError() << std::endl;
-                return;
+            if (a < 0 || b < 0 || b >= ENEMY_DIRECTIONS) {
+                std::cerr << "Invalid enemy frame " << a << " " << b << " in " << filePath << "\n";
+                continue;
             }
-            enemyTextures.insert_or_assign(
-                {a, b},
-                SDLTexturePtr(texture, SDL_DestroyTexture)
-            );
+            frames.push_back({a, b});
+            images.emplace_back();
+            images.back().path = path;
         }
         // else: silently ignore malformed / empty lines
     }
-    //std::cout<<enemyTextures.size()<<std::endl;
+
+    double decodeMs = decodeImages(workers, images);
+
+    // Frames after the first one that fails to decode are dropped, as
+    // when the list was read and decoded line by line
+    for (size_t i = 0; i < images.size(); i++)
+        if (!images[i].ok) {
+            std::cerr << "Failed to load texture: " << filePath << " Error: " << images[i].error << std::endl;
+            frames.resize(i);
+            break;
+        }
+
+    // Pack every frame into one atlas; a flat (frame, direction) table
+    // maps to its rect, later entries win like they did in the old map
+    Uint64 uploadStart = SDL_GetPerformanceCounter();
+    std::vector<const PixelTexture*> packed;
+    int frameCount = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        packed.push_back(&images[i].pixels);
+        frameCount = std::max(frameCount, frames[i].frame + 1);
+    }
+    enemyAtlasRects = packAtlas(packed, enemyAtlas);
+
+    // Mip levels pack their own atlases from per-frame mips, so filtering
+    // never mixes texels of neighbouring frames
+    int mipLevels = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        images[i].pixels.buildMips();
+        mipLevels = std::max(mipLevels, (int)images[i].pixels.mips.size());
+    }
+    enemyAtlas.mips.assign(mipLevels, PixelTexture());
+    enemyAtlasMipRects.assign(mipLevels, std::vector<AtlasRect>());
+    for (int level = 1; level <= mipLevels; level++) {
+        for (size_t i = 0; i < frames.size(); i++)
+            packed[i] = &images[i].pixels.mip(level);
+        enemyAtlasMipRects[level - 1] = packAtlas(packed, enemyAtlas.mips[level - 1],
+                                                  std::max(2048 >> level, 64));
+    }
+    enemyFrameSlots.assign((size_t)frameCount * ENEMY_DIRECTIONS, -1);
+    for (size_t i = 0; i < frames.size(); i++)
+        enemyFrameSlots[frames[i].frame * ENEMY_DIRECTIONS + frames[i].dir] = (int)i;
+
+    enemyAtlasTexture.reset(frames.empty() ? nullptr
+                                           : createTextureFromPixels(renderer.get(), enemyAtlas));
+    if (!frames.empty() && !enemyAtlasTexture)
+        std::cerr << "Failed to create enemy atlas texture: " << SDL_GetError() << "\n";
+
+    // The frames share one atlas upload, reported once for the whole list
+    reportAssetTimings(filePath, images, decodeMs, elapsedMs(uploadStart),
+                       workers.threadCount(), assetTimingReport);
+}
+
+int Game::enemyFrameSlot(int frame, int dir) const
+{
+    if (frame < 0 || dir < 0 || dir >= ENEMY_DIRECTIONS)
+        return -1;
+    size_t i = (size_t)frame * ENEMY_DIRECTIONS + dir;
+    return i < enemyFrameSlots.size() ? enemyFrameSlots[i] : -1;
 }
 
 void Game::addEnemy(float x, float y, float angle) {
-    enemies.push_back(std::make_unique<Enemy>(x, y, angle));
+    int id = enemies.add(x, y, angle);
+    enemies.seedRandom(id, randomSeed, id + 1);
+    enemyGrid.insert(id, x, y);
+}
+
+void Game::rebuildEnemyGrid()
+{
+    enemyGrid.reset(Map.width(), Map.height());
+    for (int i = 0; i < enemies.count(); i++)
+        enemyGrid.insert(i, enemies.position(i).first, enemies.position(i).second);
+}
+
+void Game::setRandomSeed(uint64_t seed)
+{
+    randomSeed = seed;
+    rng.seedWith(seed, 0);
+    // stream 0 is the game's own, enemy i uses stream i + 1
+    for (int i = 0; i < enemies.count(); i++)
+        enemies.seedRandom(i, seed, i + 1);
 }
 
 bool aabbIntersect(
@@ -823,23 +1794,27 @@ bool aabbIntersect(
 }
 
 bool Game::collidesWithEnemy(float x, float y) {
-    for (const auto& e : enemies)
-    {
-        if (aabbIntersect(
+    // Enemy boxes start at their position, so any enemy touching the player
+    // box is at most one enemy size up/left of it
+    bool hit = false;
+    float enemySize = enemies.size();
+    enemyGrid.forEachInBox(x - enemySize, y - enemySize,
+                           x + playerSquareSize, y + playerSquareSize, [&](int id) {
+        if (!hit && aabbIntersect(
             x, y,
             playerSquareSize, playerSquareSize,
-            e->get_position().first, e->get_position().second,
-            e->get_size(), e->get_size()
+            enemies.position(id).first, enemies.position(id).second,
+            enemySize, enemySize
         )) {
-            return true;
+            hit = true;
         }
-    }
-    return false;
+    });
+    return hit;
 }
 
-bool Game::rayCastEnemyToPlayer(const Enemy& enemy) {
-    float ex = enemy.get_position().first;
-    float ey = enemy.get_position().second;
+bool Game::rayCastEnemyToPlayer(int enemy) {
+    float ex = enemies.position(enemy).first;
+    float ey = enemies.position(enemy).second;
 
     float px = playerPosition.first;
     float py = playerPosition.second;
@@ -861,6 +1836,14 @@ bool Game::rayCastEnemyToPlayer(const Enemy& enemy) {
 
     int targetX = int(std::floor(px));
     int targetY = int(std::floor(py));
+    if (!Map.inBounds(mapX, mapY) || !Map.inBounds(targetX, targetY))
+        return false;
+
+    // Pairs of tiles that can never see each other skip the walk
+    if (!pvs.mayBeVisible(mapX, mapY, targetX, targetY))
+        return false;
+    if (mapX == targetX && mapY == targetY)
+        return true;
 
     // Ray step direction
     int stepX = (dx < 0) ? -1 : 1;
@@ -883,8 +1866,19 @@ bool Game::rayCastEnemyToPlayer(const Enemy& enemy) {
     else
         sideDistY = (mapY + 1.0f - ey) * deltaDistY;
 
-    // DDA loop
+    // DDA loop; the solid border ends rays that would leave the map, so no
+    // bounds check is needed per step
+    bool visible = false;
     while (true) {
+        // A player inside the open square around this tile is in plain
+        // sight; otherwise cross that square without reading its tiles
+        int reach = wallDistance.at(mapX, mapY) - 1;
+        if (reach >= std::max(std::abs(targetX - mapX), std::abs(targetY - mapY))) {
+            visible = true;
+            break;
+        }
+        wallDistance.jump(mapX, mapY, sideDistX, sideDistY, deltaDistX, deltaDistY, stepX, stepY);
+
         if (sideDistX < sideDistY) {
             sideDistX += deltaDistX;
             mapX += stepX;
@@ -893,19 +1887,19 @@ bool Game::rayCastEnemyToPlayer(const Enemy& enemy) {
             mapY += stepY;
         }
 
-        // Bounds check
-        if (mapY < 0 || mapY >= (int)Map.size() ||
-            mapX < 0 || mapX >= (int)Map[0].size())
-            return false;
-
-        // Hit wall
-        if (Map[mapY][mapX] != 0)
-            return false;
+        // Hit wall; doors only block sight while mostly closed
+        if (wallDistance.at(mapX, mapY) == 0 && Map.at(mapX, mapY) != 0) {
+            if (doorBlocks(Map.doorAt(mapX, mapY)))
+                break;
+        }
 
         // Reached player cell
-        if (mapX == targetX && mapY == targetY)
-            return true;
+        if (mapX == targetX && mapY == targetY) {
+            visible = true;
+            break;
+        }
     }
+    return visible;
 }
 
 bool Game::canShootEnemy(float dist){
@@ -917,7 +1911,7 @@ bool Game::canShootEnemy(float dist){
 
     // Quadratic falloff (feels very Wolf-like)
     int errorDivisor = ((int) (accuracyDivisor - 1) * (1.0f - t * t)) + 1;
-    return (rand() % errorDivisor) != 0;
+    return !rng.oneIn(errorDivisor);
 }
 
 void Game::loadEnemies(const char* filePath)
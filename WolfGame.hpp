@@ -2,8 +2,22 @@
 #define Game_hpp
 #include "SDL.h"
 #include "SDL_image.h"
-#include "enemy.hpp"
+#include "enemySystem.hpp"
+#include "workerPool.hpp"
+#include "pixelTexture.hpp"
+#include "tileGrid.hpp"
+#include "demo.hpp"
+#include "rng.hpp"
+#include "profiler.hpp"
+#include "enemyGrid.hpp"
+#include "visibilitySet.hpp"
+#include "levelFile.hpp"
+#include "lightTable.hpp"
+#include "resolutionScaler.hpp"
+#include "distanceField.hpp"
 #include <stdio.h>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <utility>
 #include <map>
@@ -21,12 +35,25 @@ public:
     Game();
     ~Game() ;
     void init(const char* title, int xpos, int ypos, int width, int height, bool fullscreen);
-    void handleEvents();
-    void update(float deltaTime);
+    void handleEvents();                   // pollInput + applyInput
+    InputFrame pollInput();                // drain SDL events and sample the keyboard
+    void applyInput(const InputFrame& input);
+    // Simulation runs in fixed ticks of TICK_SECONDS. advance() feeds the
+    // frame time to an accumulator, runs the ticks that are due and sets
+    // how far render() interpolates towards the latest tick.
+    static constexpr float TICK_SECONDS = 1.0f / 70.0f;
+    void advance(float frameSeconds);
+    void update(float deltaTime);   // one tick
     void render();
     void clean();
     bool running(){return isRunning;}
-    void loadMapDataFromFile(const char* filename);
+    // Walls from filename; floor, ceiling and light layers from the given
+    // files, or floor.txt / ceil.txt / light.txt next to it when those exist
+    void loadMapDataFromFile(const char* filename, const char* floorFile = nullptr,
+                             const char* ceilingFile = nullptr, const char* lightFile = nullptr);
+    // Compiled level (see levelFile.hpp): layers, doors, enemies, player
+    // start and PVS in one mapped file. Replaces the enemies added so far.
+    bool loadLevel(const char* filename);
     void loadColorConfigFromFile(const char* filename);
     void placePlayerAt(int x, int y, float angle);
     void printPlayerPosition();
@@ -41,33 +68,161 @@ public:
     bool collidesWithEnemy(float x, float y);
     bool canShootEnemy(float dist);
     void loadEnemies(const char* filePath);
+    // true: draw into a CPU framebuffer uploaded once per frame,
+    // false: one SDL_RenderCopy per column / pixel
+    void setFramebufferRendering(bool enabled){ useFramebuffer = enabled && frameTexture; }
+    // threads used for framebuffer column rendering, 0 = one per core
+    void setWorkerCount(int count);
+    // Both rebuild the per-column / per-row ray tables on the next frame
+    void setFOV(float degrees);
+    void setResolution(int width, int height);   // 3D view size, scaled to the window
+    // Framebuffer path only: renders the 3D view at a fraction of the
+    // setResolution size, chosen each frame to keep frames inside budgetMs,
+    // and scales it up. The profiler overlay stays at full size.
+    void setDynamicResolution(bool enabled, float budgetMs = 1000.0f / 60.0f);
+    // Enemies the PVS says cannot see the player's tile think at a reduced
+    // rate
+    void setAiLod(bool enabled){ aiLod = enabled; }
+    // Reseeds the game and every enemy; enemies added later are seeded too
+    void setRandomSeed(uint64_t seed);
+    // Frame profiler: rolling graph over the view (also toggled with F3)
+    // and an optional per-frame CSV dump
+    void setProfilerOverlay(bool enabled);
+    bool setProfileCsv(const char* path){ return profiler.openCsv(path); }
+    // Texture lists decode on the worker pool; this adds per-image
+    // decode/upload times to the startup report
+    void setAssetTimingReport(bool perAsset){ assetTimingReport = perAsset; }
+    // Distance fog: colour as 0xRRGGBB, minBrightness is how much of a
+    // texel is left at full fog distance (0-255)
+    void setFog(uint32_t colour, int minBrightness = 40){ light.build(colour, minBrightness, fogDistance); }
 private:
     bool isRunning;
     SDLWindowPtr   window   {nullptr, SDL_DestroyWindow};
     SDLRendererPtr renderer {nullptr, SDL_DestroyRenderer};
-    float playerAngle, FOV=45.0f, playerSpeed=2.0f, rotationSensitivity=0.05f;
+    float playerAngle, FOV=45.0f, playerSpeed=2.0f, turnSpeed=3.0f;   // turnSpeed in rad/s
     float playerHeight=0.5f, mouseSensitivity=0.002f;
     float playerSquareSize=1.0f;
     std::pair<float, float> playerPosition;
-    std::pair<int, int> ScreenHeightWidth;
+    std::pair<int, int> ScreenHeightWidth;   // 3D view as rendered: displaySize * render scale
+    std::pair<int, int> displaySize;         // setResolution size, the renderer's logical size
+    bool dynamicResolution = false;
+    ResolutionScaler resolutionScaler;
+    void applyRenderScale();
     std::pair<double, double> playerMoveDirection = {0.0, 0.0};
-    std::vector<std::vector<int>> Map, floorMap, ceilingMap;
+    uint32_t heldButtons = 0;   // InputButton bits, read by the tick
+
+    // fixed-step state; rendering draws between the previous tick and the latest
+    float tickAccumulator = 0.0f, renderAlpha = 1.0f;
+    std::pair<float, float> prevPlayerPosition, viewPosition;
+    float lastTickTurn = 0.0f;   // keyboard turn of the latest tick
+    TileGrid Map, floorMap, ceilingMap;
+    TileGrid lightMap;   // per-tile darkening in light levels, 0 = none
+    LightTable light;
+    float fogDistance = 8.0f;
+    VisibilitySet pvs;   // baked from Map at load, culls enemy line of sight
+    DistanceField wallDistance;   // baked from Map at load, lets rays skip open space
     std::vector<SDLTexturePtr> wallTextures;
     std::vector<SDLTexturePtr> floorTextures;
     std::vector<SDLTexturePtr> ceilingTextures;
     std::vector<int> wallTextureWidths, floorTextureWidths, ceilingTextureWidths;
     std::vector<int> wallTextureHeights, floorTextureHeights, ceilingTextureHeights;
+    std::vector<PixelTexture> wallPixels, floorPixels, ceilingPixels;
+    enum TextureLayer { WALL_LAYER, FLOOR_LAYER, CEILING_LAYER };
+    bool addTexture(TextureLayer layer, PixelTexture& pixels);
+    void loadTileLayer(TileGrid& layer, const char* filename, bool required);
+    bool assetTimingReport = false;
+
+    // framebuffer renderer
+    bool useFramebuffer = true;
+    std::vector<uint32_t> frameBuffer;
+    SDLTexturePtr frameTexture {nullptr, SDL_DestroyTexture};
+    std::vector<float> zBuffer;
+    WorkerPool workers;
+    int workerCount = 0;
+    int columnBandWidth = 32;   // columns per parallel band
+    int rowBandHeight = 8;      // floor/ceiling rows per parallel band
+
+    // camera basis for the current frame: ray = dir + plane * cameraX,
+    // cameraX in [-1, 1) across the screen
+    float viewDirX = 1.0f, viewDirY = 0.0f, viewPlaneX = 0.0f, viewPlaneY = 0.0f;
+
+    // ray tables, rebuilt when FOV or resolution change
+    bool viewTablesDirty = true;
+    float viewPlaneScale = 1.0f;          // tan(FOV / 2)
+    std::vector<float> columnCameraX;     // per column
+    std::vector<float> rowDistance;       // per row, floor/ceiling distance
+    void rebuildViewTables();
     struct Door {
         float openAmount;   // 0 = closed, 1 = fully open
         bool opening;       // opening animation active
         bool locked;        // requires key?
         int keyType;        // 0 = none, 1 = blue, 2 = red, 3 = gold
+        int x, y;           // tile
     };
 
-    std::map<std::pair<int,int>, Door> doors;  // key: (mapX,mapY)
+    std::vector<Door> doors;  // slot per door tile is stored in Map
     std::vector<int> keysHeld; // keys the player has collected
-    std::vector<std::unique_ptr<Enemy>> enemies;
-    std::map<std::pair<int, int>, SDLTexturePtr> enemyTextures;
+    EnemySystem enemies;
+    EnemyGrid enemyGrid;           // enemies bucketed by position, by enemy id
+    std::vector<int> drawOrder;    // sprite order, farthest first, kept across frames
+    std::vector<float> spriteDistSq;   // per enemy id, this frame's sort key
+    // A sprite that survived FOV and occlusion culling this frame
+    struct SpriteRecord {
+        float dist;
+        int slot, lightLevel;
+        int left, top, width, height;   // unclipped screen rect
+        int beginX, endX;               // columns clipped to the screen
+    };
+    std::vector<SpriteRecord> spriteRecords;
+    std::vector<float> zBlockMax;      // farthest wall per block of columns
+    void drawSpriteRun(const SpriteRecord& sprite, int begin, int end);
+    // parallel enemy update: enemies per band, and per band the enemies that
+    // changed grid cell and the damage they dealt this tick
+    int enemyBandSize = 64;
+    std::vector<std::vector<int>> enemyBandMoves;
+    std::vector<int> enemyBandDamage;
+    void rebuildEnemyGrid();
+    int findShotTarget() const;
+    // enemy frames packed into one atlas; enemyFrameSlots maps
+    // frame * ENEMY_DIRECTIONS + direction to an atlas rect, -1 if missing.
+    // enemyAtlas.mips are atlases of the frames' mip levels, with the
+    // rects of level l in enemyAtlasMipRects[l - 1]
+    PixelTexture enemyAtlas;
+    SDLTexturePtr enemyAtlasTexture {nullptr, SDL_DestroyTexture};
+    std::vector<AtlasRect> enemyAtlasRects;
+    std::vector<std::vector<AtlasRect>> enemyAtlasMipRects;
+    std::vector<int> enemyFrameSlots;
+    // renderer path: each column's wall hit (texId -1 = none), merged into
+    // quads and drawn with one SDL_RenderGeometry call per wall texture
+    struct WallColumn {
+        int texId, tileIndex, side;
+        float u, top, bottom;   // texture column and unclipped screen extent
+        Uint8 brightness;
+    };
+    struct GeometryBatch {
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+    };
+    std::vector<WallColumn> wallColumns;
+    std::vector<GeometryBatch> wallBatches;
+    void renderWallQuads();
+    // Tiles the last frame's wall pass looked at: every tile a ray crossed,
+    // the wall it stopped on and all of any open square it jumped, as a
+    // bitmap over TileGrid::index keys and as a list. Culls sprites; the
+    // simulation never reads it, so demos do not depend on rendering.
+    std::vector<std::vector<int>> seenBandTiles;   // per column band, while rendering
+    std::vector<std::vector<int>> seenBandSquares; // centres of open squares rays jumped
+    std::vector<int> seenSquareList;
+    std::vector<uint64_t> seenTileBits;
+    std::vector<int> seenTileList;
+    void beginVisibleTiles(int columns);
+    void collectVisibleTiles();
+    bool areaSeen(float x, float y) const;
+    static constexpr int AI_LOD_TICKS = 4;
+    bool aiLod = true;
+    uint64_t tickCount = 0;
+    std::vector<SDL_Vertex> spriteVertices;   // per-frame sprite batch
+    std::vector<int> spriteIndices;
 
     int health = 100;
 
@@ -76,9 +231,33 @@ private:
     int accuracyDivisor = 4; // 75% hit
     float fireCooldown = 0.0f;
     float fireDuration = 0.2f;
-    bool shotThisFrame = false, hasShot = false;
+    bool shotPending = false;   // fired since the last tick, resolved by the next one
+    bool hasShot = false;
     float alertRange = 16.0f;
-    bool rayCastEnemyToPlayer(const Enemy& enemy);
+
+    // seeded so timedemos replay identically
+    uint64_t randomSeed = 1;
+    Rng rng;
+
+    FrameProfiler profiler;
+    bool showProfiler = false;
+    void renderProfilerOverlay();
+    bool rayCastEnemyToPlayer(int enemy);
+
+    // Door state shared by rendering, collision and AI
+    Door* doorAt(int x, int y);
+    const Door* doorAt(int x, int y) const;
+    bool doorBlocks(int x, int y) const;   // closed enough to stop movement and sight
+    // By index into doors; -1, a door tile without an entry, reads as closed
+    float doorOpenAmount(int door) const;
+    bool doorBlocks(int door) const;
+    void tryOpenDoor(int x, int y);
+    void addDoor(const LevelDoor& door);
+    void updateDoors(float deltaTime);
+    void renderColumn(int ray);
+    void renderFloorAndCeilingRows(int rowBegin, int rowEnd);
+    void renderEnemies();
+    int enemyFrameSlot(int frame, int dir) const;
 
 };
 
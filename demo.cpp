@@ -0,0 +1,97 @@
+#include "demo.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// File layout, little endian:
+//   "WDEM", uint32 version, uint64 seed, uint32 frame count,
+//   then per frame: float deltaTime, int32 mouseDX, uint32 buttons
+static const char DEMO_MAGIC[4] = {'W', 'D', 'E', 'M'};
+// Version 2: frames replay through the fixed-step Game::advance
+static const uint32_t DEMO_VERSION = 2;
+
+template <typename T>
+static void writeValue(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::ifstream& in, T& value) {
+    return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+bool Demo::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Failed to write demo: " << path << "\n";
+        return false;
+    }
+    out.write(DEMO_MAGIC, sizeof(DEMO_MAGIC));
+    writeValue(out, DEMO_VERSION);
+    writeValue(out, seed);
+    writeValue(out, (uint32_t)frames.size());
+    for (const InputFrame& f : frames) {
+        writeValue(out, f.deltaTime);
+        writeValue(out, f.mouseDX);
+        writeValue(out, f.buttons);
+    }
+    return (bool)out;
+}
+
+bool Demo::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Failed to open demo: " << path << "\n";
+        return false;
+    }
+    char magic[4];
+    uint32_t version = 0, count = 0;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, DEMO_MAGIC, sizeof(magic)) != 0 ||
+        !readValue(in, version) || version != DEMO_VERSION) {
+        std::cerr << "Not a demo file (or wrong version): " << path << "\n";
+        return false;
+    }
+    if (!readValue(in, seed) || !readValue(in, count)) {
+        std::cerr << "Truncated demo: " << path << "\n";
+        return false;
+    }
+    frames.clear();
+    frames.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        InputFrame f;
+        if (!readValue(in, f.deltaTime) || !readValue(in, f.mouseDX) || !readValue(in, f.buttons)) {
+            std::cerr << "Truncated demo: " << path << "\n";
+            return false;
+        }
+        frames.push_back(f);
+    }
+    return true;
+}
+
+void FrameStats::report() const {
+    if (frameTimes.empty()) {
+        std::cout << "timedemo: no frames\n";
+        return;
+    }
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double t : sorted)
+        total += t;
+
+    // Nearest-rank percentile
+    auto percentile = [&](double p) {
+        size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.999999);
+        return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+    };
+
+    char line[256];
+    snprintf(line, sizeof(line),
+             "timedemo: %zu frames in %.1f ms, %.1f fps avg | "
+             "frame ms p50 %.2f  p95 %.2f  p99 %.2f  max %.2f\n",
+             sorted.size(), total, 1000.0 * sorted.size() / total,
+             percentile(50), percentile(95), percentile(99), sorted.back());
+    std::cout << line;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Input the game consumes in one frame, as recorded in a demo.
+enum InputButton : uint32_t {
+    INPUT_FORWARD      = 1 << 0,
+    INPUT_BACK         = 1 << 1,
+    INPUT_STRAFE_LEFT  = 1 << 2,
+    INPUT_STRAFE_RIGHT = 1 << 3,
+    INPUT_TURN_LEFT    = 1 << 4,
+    INPUT_TURN_RIGHT   = 1 << 5,
+    INPUT_USE          = 1 << 6,
+    INPUT_FIRE         = 1 << 7,
+};
+
+struct InputFrame {
+    float deltaTime = 0.0f;   // frame time in seconds, fed to Game::advance
+    int32_t mouseDX = 0;      // summed relative mouse motion
+    uint32_t buttons = 0;     // InputButton bits
+};
+
+// A recorded session: the random seed it started from and every frame's
+// input. Played back from the same level start it reproduces the session
+// exactly.
+struct Demo {
+    uint64_t seed = 1;
+    std::vector<InputFrame> frames;
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+};
+
+// Frame times collected during a timedemo.
+class FrameStats {
+public:
+    void add(double milliseconds) { frameTimes.push_back(milliseconds); }
+    // Prints frame count, average FPS and p50/p95/p99/max frame time
+    void report() const;
+
+private:
+    std::vector<double> frameTimes;
+};
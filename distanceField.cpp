@@ -0,0 +1,69 @@
+#include "distanceField.hpp"
+#include <vector>
+
+// Two raster passes over a width x height block, each tile taking the
+// smallest neighbour seen so far plus one. With all eight neighbours
+// weighted 1 this is the exact chessboard distance. Tiles holding 0 are
+// solid; the rest start at MAX_DISTANCE.
+static void chamfer(std::vector<uint8_t>& d, int width, int height)
+{
+    auto relax = [&](int x, int y, int nx, int ny) {
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+            return;
+        uint8_t& v = d[(size_t)y * width + x];
+        v = std::min<int>(v, d[(size_t)ny * width + nx] + 1);
+    };
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            relax(x, y, x - 1, y);
+            relax(x, y, x - 1, y - 1);
+            relax(x, y, x, y - 1);
+            relax(x, y, x + 1, y - 1);
+        }
+    for (int y = height - 1; y >= 0; y--)
+        for (int x = width - 1; x >= 0; x--) {
+            relax(x, y, x + 1, y);
+            relax(x, y, x + 1, y + 1);
+            relax(x, y, x, y + 1);
+            relax(x, y, x - 1, y + 1);
+        }
+}
+
+void DistanceField::build(const TileGrid& map)
+{
+    w = map.width();
+    h = map.height();
+    int width = w + 2, height = h + 2;
+    std::vector<uint8_t> d((size_t)width * height);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            d[(size_t)y * width + x] = map.at(x - 1, y - 1) != 0 ? 0 : MAX_DISTANCE;
+    chamfer(d, width, height);
+    distances.build(width, height, [&](int x, int y) { return (uint16_t)d[(size_t)y * width + x]; });
+}
+
+void DistanceField::setSolid(int x, int y, bool solid)
+{
+    if (x < 0 || y < 0 || x >= w || y >= h || (at(x, y) == 0) == solid)
+        return;
+
+    // Tiles within MAX_DISTANCE of (x, y) can change. Their nearest solid
+    // tile that counts is at most MAX_DISTANCE further out, and the chamfer
+    // path to it stays inside that window, so redoing the window from the
+    // current solidity is exact for the inner square.
+    int gx = x + 1, gy = y + 1;   // storage coordinates, border included
+    int x0 = std::max(gx - 2 * MAX_DISTANCE, 0), x1 = std::min(gx + 2 * MAX_DISTANCE, w + 1);
+    int y0 = std::max(gy - 2 * MAX_DISTANCE, 0), y1 = std::min(gy + 2 * MAX_DISTANCE, h + 1);
+    int width = x1 - x0 + 1, height = y1 - y0 + 1;
+    std::vector<uint8_t> d((size_t)width * height);
+    for (int wy = 0; wy < height; wy++)
+        for (int wx = 0; wx < width; wx++) {
+            bool isSolid = (x0 + wx == gx && y0 + wy == gy) ? solid : distances.get(x0 + wx, y0 + wy) == 0;
+            d[(size_t)wy * width + wx] = isSolid ? 0 : MAX_DISTANCE;
+        }
+    chamfer(d, width, height);
+
+    for (int sy = std::max(gy - MAX_DISTANCE, y0); sy <= std::min(gy + MAX_DISTANCE, y1); sy++)
+        for (int sx = std::max(gx - MAX_DISTANCE, x0); sx <= std::min(gx + MAX_DISTANCE, x1); sx++)
+            distances.set(sx, sy, d[(size_t)(sy - y0) * width + (sx - x0)]);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include "tileGrid.hpp"
+
+// Chebyshev distance from every tile to the nearest solid one, capped at
+// MAX_DISTANCE and baked at map load. A tile at distance d has only empty
+// tiles within d - 1 tiles of it in every direction, so a DDA ray standing
+// there can cross that whole square without reading any of its tiles and
+// only look at the map near geometry. Solid tiles read 0, so the field
+// doubles as the solidity test. Stored in TileChunks like the map: open
+// space beyond MAX_DISTANCE and solid rock share chunks.
+class DistanceField {
+public:
+    static constexpr int MAX_DISTANCE = 8;
+
+    // Every non-zero tile of map is solid, including doors: they are
+    // closed at load
+    DistanceField() { build(TileGrid()); }
+    void build(const TileGrid& map);
+
+    // Changes one tile's solidity and refreshes the tiles within
+    // MAX_DISTANCE of it, the only ones whose distance can change
+    void setSolid(int x, int y, bool solid);
+
+    // Valid for -1 <= x <= width and -1 <= y <= height, like TileGrid::at
+    int at(int x, int y) const { return distances.get(x + 1, y + 1); }
+
+    // Advances a DDA ray standing in tile (mapX, mapY) to the last tile it
+    // reaches before leaving the empty square around it. Returns false and
+    // leaves the ray alone when the square is just the tile itself.
+    // The crossings are taken one by one with the walk's own comparison and
+    // additions, only without reading tiles, so the ray ends in exactly the
+    // state the tile-by-tile walk would reach, ties and rounding included.
+    // That keeps the cost linear in the crossings: what a jump saves is the
+    // tile read and hit test of each one, not the stepping.
+    bool jump(int& mapX, int& mapY, float& sideDistX, float& sideDistY,
+              float deltaDistX, float deltaDistY, int stepX, int stepY) const {
+        int reach = at(mapX, mapY) - 1;
+        if (reach < 1)
+            return false;
+        int crossX = 0, crossY = 0;
+        while (true) {
+            if (sideDistX < sideDistY) {
+                if (crossX == reach)
+                    break;
+                sideDistX += deltaDistX;
+                crossX++;
+            } else {
+                if (crossY == reach)
+                    break;
+                sideDistY += deltaDistY;
+                crossY++;
+            }
+        }
+        mapX += crossX * stepX;
+        mapY += crossY * stepY;
+        return true;
+    }
+
+private:
+    int w = 0, h = 0;
+    TileChunks distances;   // (width + 2) x (height + 2), border included
+};
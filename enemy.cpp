@@ -219,7 +219,7 @@ void Enemy::think(const std::pair<float, float>& playerPosition){
             float ny = dy / dist;
 
             // Random angular error
-            float r = static_cast<float>(rand()) / RAND_MAX; // [0,1]
+            float r = rng.nextFloat(); // [0,1]
             float error = (r * 2.0f - 1.0f) * walk_angle_error;
 
             float baseAngle = std::atan2(-ny, nx);
@@ -258,15 +258,12 @@ void Enemy::takeDamage(int dmg){
 }
 
 bool Enemy::canEnterPain(){
-    if(rand() % painChanceDivisor == 0)
-        return true;
-    return false;
+    return rng.oneIn(painChanceDivisor);
 }
 
 bool Enemy::randomAttackChance(int chanceDivisor){
-    if(rand() % chanceDivisor == 0)
-        return true;
-    return false;
+    // computeEnemyHitChance falls to 0 at the edge of attack range
+    return rng.oneIn(chanceDivisor);
 }
 int Enemy::computeEnemyHitChance(float dist) {
     const float MIN_DIST = 3.0f;
@@ -279,7 +276,7 @@ int Enemy::computeEnemyHitChance(float dist) {
     return (int) attackChanceDivisor * (1.0f - t * t);
 }
 int Enemy::rollEnemyDamage() {
-    return baseDamage + (rand() % damageSpread) - (damageSpread / 2);
+    return baseDamage + rng.nextInt(damageSpread) - (damageSpread / 2);
 }
 void Enemy::alert(){
     alerted = true;
@@ -3,7 +3,9 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include "rng.hpp"
 #define PI 3.1415926535f
+constexpr int ENEMY_DIRECTIONS = 8;   // sprite angles, see updateDirnNumWrt
 // HERE ANGLES ARE TAKEN POSITIVE ANTI-CLOCKWISE FROM TOP CONTRARY TO THE PLAYER
 enum EnemyState {
     ENEMY_IDLE,
@@ -18,8 +20,11 @@ void load_enemy_textures(
     std::map<std::pair<int, int>, std::string>& Textures
 );
 
+// One heap-allocated object per enemy. The game runs EnemySystem
+// (enemySystem.hpp); this class stays as the -bench-enemies baseline.
 class Enemy {
-    EnemyState state; 
+    EnemyState state = ENEMY_IDLE;
+    Rng rng;   // per-enemy stream so demos replay identically
     bool walking = false;
     float walk_segment_length = 1.5f;
 
@@ -58,6 +63,7 @@ public:
     void addFrames(const std::map<EnemyState, std::vector<int>>& Anim);
     void setAnimState(EnemyState s, bool );
     void init();
+    void seedRandom(uint64_t seed, uint64_t stream) { rng.seedWith(seed, stream); }
     void updateDirnNumWrt(const std::pair<float, float>& pos);
     int get_current_frame() const;
     int get_dirn_num() const;
@@ -0,0 +1,54 @@
+#include "enemyGrid.hpp"
+
+void EnemyGrid::reset(int mapWidth, int mapHeight)
+{
+    cellsX = std::max(1, (mapWidth + CELL_SIZE - 1) / CELL_SIZE);
+    cellsY = std::max(1, (mapHeight + CELL_SIZE - 1) / CELL_SIZE);
+    cellHead.assign((size_t)cellsX * cellsY, -1);
+    nextInCell.clear();
+    prevInCell.clear();
+    cellOf.clear();
+}
+
+void EnemyGrid::insert(int id, float x, float y)
+{
+    if (id >= (int)cellOf.size()) {
+        nextInCell.resize(id + 1, -1);
+        prevInCell.resize(id + 1, -1);
+        cellOf.resize(id + 1, -1);
+    }
+    if (cellOf[id] != -1)
+        unlink(id);
+    link(id, cellIndex(x, y));
+}
+
+void EnemyGrid::move(int id, float x, float y)
+{
+    int cell = cellIndex(x, y);
+    if (cellOf[id] == cell)
+        return;
+    unlink(id);
+    link(id, cell);
+}
+
+void EnemyGrid::link(int id, int cell)
+{
+    cellOf[id] = cell;
+    prevInCell[id] = -1;
+    nextInCell[id] = cellHead[cell];
+    if (cellHead[cell] != -1)
+        prevInCell[cellHead[cell]] = id;
+    cellHead[cell] = id;
+}
+
+void EnemyGrid::unlink(int id)
+{
+    int cell = cellOf[id];
+    if (prevInCell[id] != -1)
+        nextInCell[prevInCell[id]] = nextInCell[id];
+    else
+        cellHead[cell] = nextInCell[id];
+    if (nextInCell[id] != -1)
+        prevInCell[nextInCell[id]] = prevInCell[id];
+    cellOf[id] = -1;
+}
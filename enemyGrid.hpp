@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+// Uniform grid of cells over the map that buckets enemies by position, so
+// collision, hitscan and alert queries only visit nearby enemies.
+// Each cell holds an intrusive doubly linked list of enemy ids (indices
+// into Game::enemies), which makes moving an enemy between cells O(1).
+// Positions outside the map clamp to the edge cells, so every id is
+// always somewhere in the grid and queries stay exact.
+class EnemyGrid {
+public:
+    static constexpr int CELL_SIZE = 2;   // tiles per cell side
+
+    // Sizes the grid for a map and drops every id
+    void reset(int mapWidth, int mapHeight);
+
+    void insert(int id, float x, float y);
+    // Relinks id only when its cell changed
+    void move(int id, float x, float y);
+    // Read-only, so parallel updates can find the ids to move afterwards
+    bool changesCell(int id, float x, float y) const { return cellOf[id] != cellIndex(x, y); }
+
+    // Calls fn(id) for every id whose position may lie in the box;
+    // the caller still does the exact test
+    template <typename Fn>
+    void forEachInBox(float minX, float minY, float maxX, float maxY, Fn&& fn) const {
+        int cx0 = cellCoord(minX, cellsX), cx1 = cellCoord(maxX, cellsX);
+        int cy0 = cellCoord(minY, cellsY), cy1 = cellCoord(maxY, cellsY);
+        for (int cy = cy0; cy <= cy1; cy++)
+            for (int cx = cx0; cx <= cx1; cx++)
+                for (int id = cellHead[cy * cellsX + cx]; id != -1; id = nextInCell[id])
+                    fn(id);
+    }
+
+private:
+    int cellsX = 1, cellsY = 1;
+    std::vector<int> cellHead = std::vector<int>(1, -1);
+    std::vector<int> nextInCell, prevInCell, cellOf;
+
+    static int cellCoord(float v, int cells) {
+        int c = v < 0.0f ? 0 : (int)v / CELL_SIZE;
+        return std::min(c, cells - 1);
+    }
+    int cellIndex(float x, float y) const { return cellCoord(y, cellsY) * cellsX + cellCoord(x, cellsX); }
+    void link(int id, int cell);
+    void unlink(int id);
+};
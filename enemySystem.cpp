@@ -0,0 +1,213 @@
+#include "enemySystem.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const int IDLE_FRAMES[]  = {0};
+static const int WALK_FRAMES[]  = {1, 2, 3, 4};
+static const int SHOOT_FRAMES[] = {5, 6, 7};
+static const int PAIN_FRAMES[]  = {8, 9};
+static const int DEAD_FRAMES[]  = {10, 11, 12, 13};
+
+const EnemyAnimation ENEMY_ANIMATIONS[ENEMY_STATE_COUNT] = {
+    {IDLE_FRAMES, 1},    // ENEMY_IDLE
+    {WALK_FRAMES, 4},    // ENEMY_WALK
+    {SHOOT_FRAMES, 3},   // ENEMY_SHOOT
+    {PAIN_FRAMES, 2},    // ENEMY_PAIN
+    {DEAD_FRAMES, 4},    // ENEMY_DEAD
+};
+
+static float normalizeAngle(float a) {
+    while (a <= -M_PI) a += 2.0f * M_PI;
+    while (a >   M_PI) a -= 2.0f * M_PI;
+    return a;
+}
+
+int EnemySystem::add(float x, float y, float theta)
+{
+    posX.push_back(x);      posY.push_back(y);
+    prevX.push_back(x);     prevY.push_back(y);
+    destX.push_back(x);     destY.push_back(y);
+    angle.push_back(theta);
+    walkDirX.push_back(std::cos(theta));
+    walkDirY.push_back(-std::sin(theta));
+    stride.push_back(1);
+    age.push_back(0);
+    thinkTimer.push_back(0.0f);
+    fracTime.push_back(0.0f);
+    state.push_back(ENEMY_IDLE);
+    frameIndex.push_back(0);
+    frame.push_back(ENEMY_ANIMATIONS[ENEMY_IDLE].frames[0]);
+    health.push_back(100);
+    damageThisFrame.push_back(0);
+    walking.push_back(0);
+    alerted.push_back(0);
+    canSeePlayer.push_back(0);
+    justTookDamage.push_back(0);
+    isDead.push_back(0);
+    stateLocked.push_back(0);
+    rng.emplace_back();
+    return count() - 1;
+}
+
+void EnemySystem::clear()
+{
+    for (auto* v : {&posX, &posY, &prevX, &prevY, &destX, &destY, &angle, &walkDirX, &walkDirY,
+                    &thinkTimer, &fracTime})
+        v->clear();
+    for (auto* v : {&frameIndex, &frame, &health, &damageThisFrame})
+        v->clear();
+    for (auto* v : {&stride, &age, &state, &walking, &alerted, &canSeePlayer, &justTookDamage, &isDead, &stateLocked})
+        v->clear();
+    rng.clear();
+}
+
+void EnemySystem::process(int i, float deltaTime, float playerX, float playerY)
+{
+    if (isDead[i]) return;
+    if (!stateLocked[i])
+        thinkTimer[i] += deltaTime;
+
+    if (thinkTimer[i] > stats.thinkInterval) {
+        thinkTimer[i] = 0.0f;
+        think(i, playerX, playerY);
+    }
+
+    if (state[i] != ENEMY_IDLE) {
+        const EnemyAnimation& anim = ENEMY_ANIMATIONS[state[i]];
+        fracTime[i] += deltaTime;
+        while (fracTime[i] > stats.durationPerSprite) {
+            frameIndex[i] = (frameIndex[i] + 1) % anim.count;
+            frame[i] = anim.frames[frameIndex[i]];
+            fracTime[i] -= stats.durationPerSprite;
+            if (frameIndex[i] == anim.count - 1) {
+                if (state[i] == ENEMY_DEAD) {
+                    isDead[i] = 1;
+                    stateLocked[i] = 1;
+                    return;
+                }
+                if (!walking[i]) {   // Pain or shooting end
+                    stateLocked[i] = 0;
+                    thinkTimer[i] = 0.0f;
+                    fracTime[i] = 0.0f;
+                    if (state[i] == ENEMY_SHOOT)
+                        damageThisFrame[i] = stats.baseDamage + rng[i].nextInt(stats.damageSpread)
+                                           - stats.damageSpread / 2;
+                }
+            }
+        }
+    }
+    else {
+        fracTime[i] = 0.0f;
+        frameIndex[i] = 0;
+        frame[i] = ENEMY_ANIMATIONS[ENEMY_IDLE].frames[0];
+    }
+    if (walking[i]) {
+        float dx = destX[i] - posX[i];
+        float dy = destY[i] - posY[i];
+        float step = stats.moveSpeed * deltaTime;
+
+        if (dx*dx + dy*dy <= step*step) {
+            posX[i] = destX[i];
+            posY[i] = destY[i];
+            walking[i] = 0;
+            setAnimState(i, ENEMY_IDLE, false);
+            stateLocked[i] = 0;
+        } else {
+            posX[i] += step * walkDirX[i];
+            posY[i] += step * walkDirY[i];
+        }
+    }
+}
+
+void EnemySystem::setAnimState(int i, EnemyState s, bool lock)
+{
+    if (state[i] == s) return;
+
+    state[i] = s;
+    stateLocked[i] = lock;
+    frameIndex[i] = 0;
+    frame[i] = ENEMY_ANIMATIONS[s].frames[0];
+    fracTime[i] = 0.0f;
+}
+
+// Same sectors as Enemy::updateDirnNumWrt
+int EnemySystem::direction(int i, float viewerX, float viewerY) const
+{
+    float targetAngle = std::atan2(-(viewerY - posY[i]), viewerX - posX[i]);
+    float relAngle = normalizeAngle(targetAngle - angle[i]);
+    const float sectorSize = M_PI / 4.0f;
+    int dir = static_cast<int>(std::floor((relAngle + M_PI / 8.0f) / sectorSize));
+    if (dir < 0) dir += 8;
+    return dir % 8;
+}
+
+int EnemySystem::attackChance(float dist) const
+{
+    const float MIN_DIST = 3.0f;
+    const float MAX_DIST = stats.attackRange + 1.0f;
+
+    dist = std::clamp(dist, MIN_DIST, MAX_DIST);
+    float t = (dist - MIN_DIST) / (MAX_DIST - MIN_DIST);
+
+    // Quadratic falloff (feels very Wolf-like)
+    return (int) stats.attackChanceDivisor * (1.0f - t * t);
+}
+
+void EnemySystem::think(int i, float playerX, float playerY)
+{
+    if (stateLocked[i])
+        return;
+    if (health[i] <= 0 && !isDead[i]) {
+        setAnimState(i, ENEMY_DEAD, true);
+        return;
+    }
+    if (justTookDamage[i]) {
+        justTookDamage[i] = 0;
+        if (rng[i].oneIn(stats.painChanceDivisor)) {
+            setAnimState(i, ENEMY_PAIN, true);
+            return;
+        }
+    }
+    float dx = playerX - posX[i];
+    float dy = playerY - posY[i];
+    float dist = std::hypot(dx, dy);
+    bool inAttackRange = dist <= stats.attackRange;
+    // A divisor of 0 at the edge of range means no shot
+    if (canSeePlayer[i] && inAttackRange && rng[i].oneIn(attackChance(dist))) {
+        setAnimState(i, ENEMY_SHOOT, true);
+        return;
+    }
+    if (canSeePlayer[i] || alerted[i]) {
+        if (!walking[i]) {
+            if (dist < 3.0f)
+                return;
+
+            // Random angular error around the direction to the player
+            float error = (rng[i].nextFloat() * 2.0f - 1.0f) * stats.walkAngleError;
+            float finalAngle = std::atan2(-dy / dist, dx / dist) + error;
+
+            // Walk a segment of at most walkSegmentLength
+            float walkDist = std::min(dist, stats.walkSegmentLength);
+            destX[i] = posX[i] + walkDist * std::cos(finalAngle);
+            destY[i] = posY[i] - walkDist * std::sin(finalAngle);
+
+            angle[i] = std::atan2(-(destY[i] - posY[i]), destX[i] - posX[i]);
+            walkDirX[i] = std::cos(angle[i]);
+            walkDirY[i] = -std::sin(angle[i]);
+
+            setAnimState(i, ENEMY_WALK, true);
+            walking[i] = 1;
+        }
+        return;
+    }
+    setAnimState(i, ENEMY_IDLE, false);
+}
+
+void EnemySystem::takeDamage(int i, int damage)
+{
+    justTookDamage[i] = 1;
+    health[i] -= damage;
+    std::cout << "Enemy took " << damage << " damage, health now " << health[i] << std::endl;
+    if (health[i] < 0) health[i] = 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "enemy.hpp"
+#include "rng.hpp"
+
+constexpr int ENEMY_STATE_COUNT = ENEMY_DEAD + 1;
+
+// Frame sequence of one state; every enemy plays the same ones
+struct EnemyAnimation {
+    const int* frames;
+    int count;
+};
+extern const EnemyAnimation ENEMY_ANIMATIONS[ENEMY_STATE_COUNT];
+
+// Tuning shared by every enemy (what each Enemy carries as members)
+struct EnemyStats {
+    float size = 1.0f;
+    float moveSpeed = 1.0f;
+    float durationPerSprite = 0.25f;
+    float thinkInterval = 0.3f;
+    float walkSegmentLength = 1.5f;
+    float walkAngleError = 10.0f * M_PI / 180.0f;   // ±10 degrees
+    float attackRange = 7.0f;
+    int baseDamage = 10, damageSpread = 5;
+    int attackChanceDivisor = 2;
+    int painChanceDivisor = 4;   // 1 in 4 chance
+};
+
+// Every enemy of a level, stored as parallel arrays indexed by enemy id.
+// Runs the same AI and animation as Enemy, but a tick walks a few dense
+// arrays instead of chasing a heap object (and its animation map) per enemy.
+class EnemySystem {
+public:
+    EnemyStats stats;
+
+    int add(float x, float y, float angle);   // returns the new id
+    void clear();
+    int count() const { return (int)posX.size(); }
+
+    // One simulation tick of enemy id against the player position
+    void process(int id, float deltaTime, float playerX, float playerY);
+
+    std::pair<float, float> position(int id) const { return {posX[id], posY[id]}; }
+    // Position as drawn alpha (0-1) of a tick after the latest one. The
+    // last step is spread over the ticks it stands for, so an enemy that
+    // thinks every few ticks glides instead of jumping.
+    std::pair<float, float> interpolatedPosition(int id, float alpha) const {
+        float t = (age[id] + alpha) / stride[id];
+        if (t >= 1.0f)
+            return {posX[id], posY[id]};
+        return {prevX[id] + (posX[id] - prevX[id]) * t,
+                prevY[id] + (posY[id] - prevY[id]) * t};
+    }
+    // Call before the process() of a step covering `ticks` ticks. The step
+    // starts where the enemy is drawn now, so a stride change mid-way
+    // does not jump.
+    void beginStep(int id, int ticks) {
+        std::tie(prevX[id], prevY[id]) = interpolatedPosition(id, 1.0f);
+        stride[id] = (uint8_t)ticks;
+        age[id] = 0;
+    }
+    // A tick passed without a step
+    void skipTick(int id) { if (age[id] < stride[id]) age[id]++; }
+    float size() const { return stats.size; }
+    int currentFrame(int id) const { return frame[id]; }
+    // Sprite angle (0-7) seen from a viewer. Only drawing needs it, so it
+    // is worked out for visible enemies instead of every enemy every tick.
+    int direction(int id, float viewerX, float viewerY) const;
+
+    void seedRandom(int id, uint64_t seed, uint64_t stream) { rng[id].seedWith(seed, stream); }
+    void setCanSeePlayer(int id, bool visible) { canSeePlayer[id] = visible; }
+    bool seesPlayer(int id) const { return canSeePlayer[id]; }
+    void takeDamage(int id, int damage);
+    // Damage dealt to the player this tick, cleared by the read
+    int takeDamageDealt(int id) { int d = damageThisFrame[id]; damageThisFrame[id] = 0; return d; }
+    void alert(int id) { alerted[id] = 1; }
+    bool isAlerted(int id) const { return alerted[id]; }
+
+private:
+    // kinematics
+    std::vector<float> posX, posY, prevX, prevY, destX, destY, angle;
+    std::vector<float> walkDirX, walkDirY;   // cos / -sin of angle, set with it
+    std::vector<uint8_t> stride, age;        // ticks the last step covers / ticks since it
+    // AI and animation
+    std::vector<float> thinkTimer, fracTime;
+    std::vector<uint8_t> state;   // EnemyState
+    std::vector<int> frameIndex, frame;
+    std::vector<int> health, damageThisFrame;
+    std::vector<uint8_t> walking, alerted, canSeePlayer, justTookDamage, isDead, stateLocked;
+    std::vector<Rng> rng;
+
+    void think(int id, float playerX, float playerY);
+    void setAnimState(int id, EnemyState s, bool lock);
+    int attackChance(float dist) const;
+};
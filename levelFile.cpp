@@ -0,0 +1,284 @@
+#include "levelFile.hpp"
+#include "tileGrid.hpp"
+#include "visibilitySet.hpp"
+#include "workerPool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool doorFromTile(int tile, int x, int y, LevelDoor& door)
+{
+    if (tile < 6 || tile > 9)
+        return false;
+    door.x = (uint16_t)x;
+    door.y = (uint16_t)y;
+    door.locked = tile != 6;
+    door.keyType = (uint8_t)(tile - 6);   // 7 blue, 8 red, 9 gold
+    door.reserved = 0;
+    return true;
+}
+
+bool readTextLayer(const char* path, std::vector<std::vector<int>>& rows)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open map data file: " << path << std::endl;
+        return false;
+    }
+    rows.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<int> row;
+        bool separated = false;
+        for (size_t i = 1; i + 1 < line.size() && !separated; i++)
+            separated = isspace((unsigned char)line[i]) && isdigit((unsigned char)line[i - 1]);
+        if (separated) {
+            std::istringstream iss(line);
+            int tile;
+            while (iss >> tile)
+                row.push_back(tile);
+        }
+        else {
+            for (char ch : line)
+                if (ch >= '0' && ch <= '9')
+                    row.push_back(ch - '0');
+        }
+        rows.push_back(row);
+        if (row.size() > (size_t)TileGrid::MAX_SIDE || rows.size() > (size_t)TileGrid::MAX_SIDE) {
+            std::cerr << "Map too large (more than " << TileGrid::MAX_SIDE << " tiles a side): " << path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copies ragged rows into a width x height layer, missing tiles stay 0
+static std::vector<uint16_t> flattenLayer(const std::vector<std::vector<int>>& rows, int width, int height)
+{
+    std::vector<uint16_t> layer((size_t)width * height, 0);
+    for (int y = 0; y < height && y < (int)rows.size(); y++)
+        for (int x = 0; x < width && x < (int)rows[y].size(); x++)
+            layer[(size_t)y * width + x] = (uint16_t)rows[y][x];
+    return layer;
+}
+
+bool levelFromText(LevelData& level, const char* wallsPath, const char* floorsPath,
+                   const char* ceilingsPath, const char* lightsPath, const char* enemiesPath)
+{
+    std::vector<std::vector<int>> walls, floors, ceilings, lights;
+    if (!readTextLayer(wallsPath, walls))
+        return false;
+    if (floorsPath && !readTextLayer(floorsPath, floors))
+        return false;
+    if (ceilingsPath && !readTextLayer(ceilingsPath, ceilings))
+        return false;
+    if (lightsPath && !readTextLayer(lightsPath, lights))
+        return false;
+
+    level.width = 0;
+    for (const auto& row : walls)
+        level.width = std::max(level.width, (int)row.size());
+    level.height = (int)walls.size();
+    level.walls = flattenLayer(walls, level.width, level.height);
+    level.floors = flattenLayer(floors, level.width, level.height);
+    level.ceilings = flattenLayer(ceilings, level.width, level.height);
+    level.lights = flattenLayer(lights, level.width, level.height);
+
+    level.doors.clear();
+    for (int y = 0; y < level.height; y++)
+        for (int x = 0; x < level.width; x++) {
+            LevelDoor door;
+            if (doorFromTile(level.walls[(size_t)y * level.width + x], x, y, door))
+                level.doors.push_back(door);
+        }
+
+    level.enemies.clear();
+    if (enemiesPath) {
+        std::ifstream file(enemiesPath);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open enemy file: " << enemiesPath << '\n';
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream iss(line);
+            LevelEnemy enemy = {0.0f, 0.0f, 0.0f};
+            if (iss >> enemy.x >> enemy.y)
+                level.enemies.push_back(enemy);
+            else
+                std::cerr << "Invalid enemy entry: " << line << '\n';
+        }
+    }
+
+    // Bake the PVS the game would otherwise build at every load
+    TileGrid map;
+    map.resize(level.width, level.height);
+    map.assignRows(level.walls.data());
+    for (size_t i = 0; i < level.doors.size(); i++)
+        map.setDoor(level.doors[i].x, level.doors[i].y, (int)i);
+    WorkerPool workers(0);
+    VisibilitySet pvs;
+    pvs.build(map, workers);
+    level.pvsTileSets.assign(pvs.tileSets().begin(), pvs.tileSets().end());
+    level.pvsSets = pvs.setWords();
+    level.pvsWordsPerSet = pvs.wordsPerSetCount();
+    return true;
+}
+
+static uint32_t alignUp(size_t offset) { return (uint32_t)((offset + 7) & ~(size_t)7); }
+
+bool writeLevel(const char* path, const LevelData& level)
+{
+    size_t tiles = (size_t)level.width * level.height;
+    // Offsets are 32-bit; bound the file with every section padded
+    size_t largest = sizeof(LevelHeader) + tiles * (4 * sizeof(uint16_t) + sizeof(int32_t)) +
+                     level.doors.size() * sizeof(LevelDoor) + level.enemies.size() * sizeof(LevelEnemy) +
+                     level.pvsSets.size() * sizeof(uint64_t) + 8 * 7;
+    if (largest > UINT32_MAX) {
+        std::cerr << "Level too large for the file format (" << level.width << "x" << level.height
+                  << "): " << path << "\n";
+        return false;
+    }
+    LevelHeader header = {};
+    memcpy(header.magic, "WLVL", 4);
+    header.version = LEVEL_VERSION;
+    header.width = level.width;
+    header.height = level.height;
+    header.doorCount = (uint32_t)level.doors.size();
+    header.enemyCount = (uint32_t)level.enemies.size();
+    header.playerX = level.playerX;
+    header.playerY = level.playerY;
+    header.playerAngle = level.playerAngle;
+    header.wallsOffset = alignUp(sizeof(LevelHeader));
+    header.floorsOffset = alignUp(header.wallsOffset + tiles * sizeof(uint16_t));
+    header.ceilingsOffset = alignUp(header.floorsOffset + tiles * sizeof(uint16_t));
+    header.lightsOffset = alignUp(header.ceilingsOffset + tiles * sizeof(uint16_t));
+    header.doorsOffset = alignUp(header.lightsOffset + tiles * sizeof(uint16_t));
+    header.enemiesOffset = alignUp(header.doorsOffset + level.doors.size() * sizeof(LevelDoor));
+    size_t end = header.enemiesOffset + level.enemies.size() * sizeof(LevelEnemy);
+    if (!level.pvsTileSets.empty()) {
+        header.pvsOffset = alignUp(end);
+        header.pvsWordsPerSet = level.pvsWordsPerSet;
+        header.pvsSetCount = level.pvsWordsPerSet ? (uint32_t)(level.pvsSets.size() / level.pvsWordsPerSet) : 0;
+        end = alignUp(header.pvsOffset + tiles * sizeof(int32_t)) + level.pvsSets.size() * sizeof(uint64_t);
+    }
+    header.fileSize = (uint32_t)end;
+
+    std::vector<unsigned char> bytes(end, 0);
+    auto put = [&](uint32_t offset, const void* data, size_t size) {
+        if (size) memcpy(bytes.data() + offset, data, size);
+    };
+    put(0, &header, sizeof(header));
+    put(header.wallsOffset, level.walls.data(), tiles * sizeof(uint16_t));
+    put(header.floorsOffset, level.floors.data(), tiles * sizeof(uint16_t));
+    put(header.ceilingsOffset, level.ceilings.data(), tiles * sizeof(uint16_t));
+    put(header.lightsOffset, level.lights.data(), tiles * sizeof(uint16_t));
+    put(header.doorsOffset, level.doors.data(), level.doors.size() * sizeof(LevelDoor));
+    put(header.enemiesOffset, level.enemies.data(), level.enemies.size() * sizeof(LevelEnemy));
+    if (header.pvsOffset) {
+        put(header.pvsOffset, level.pvsTileSets.data(), tiles * sizeof(int32_t));
+        put(alignUp(header.pvsOffset + tiles * sizeof(int32_t)), level.pvsSets.data(),
+            level.pvsSets.size() * sizeof(uint64_t));
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open() || !out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size())) {
+        std::cerr << "Failed to write level: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool MappedLevel::open(const char* path)
+{
+    close();
+#ifndef _WIN32
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open level: " << path << "\n";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            base = static_cast<const unsigned char*>(mapped);
+            size = (size_t)st.st_size;
+        }
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open())
+        fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (!fallback.empty()) {
+        base = fallback.data();
+        size = fallback.size();
+    }
+#endif
+    if (!base) {
+        std::cerr << "Failed to map level: " << path << "\n";
+        return false;
+    }
+
+    // Everything the accessors hand out must lie inside the file
+    if (size < sizeof(LevelHeader)) {
+        std::cerr << "Not a level file: " << path << "\n";
+        close();
+        return false;
+    }
+    const LevelHeader& h = header();
+    size_t tiles = (size_t)h.width * h.height;
+    auto fits = [&](uint32_t offset, size_t bytes) { return offset % 8 == 0 && offset + bytes <= size; };
+    bool valid = memcmp(h.magic, "WLVL", 4) == 0 && h.version == LEVEL_VERSION && h.fileSize == size;
+    if (valid && (h.width > (uint32_t)TileGrid::MAX_SIDE || h.height > (uint32_t)TileGrid::MAX_SIDE)) {
+        std::cerr << "Level too large (" << h.width << "x" << h.height << ", at most "
+                  << TileGrid::MAX_SIDE << " tiles a side): " << path << "\n";
+        close();
+        return false;
+    }
+    valid = valid &&
+            fits(h.wallsOffset, tiles * 2) && fits(h.floorsOffset, tiles * 2) &&
+            fits(h.ceilingsOffset, tiles * 2) && fits(h.lightsOffset, tiles * 2) &&
+            fits(h.doorsOffset, (size_t)h.doorCount * sizeof(LevelDoor)) &&
+            fits(h.enemiesOffset, (size_t)h.enemyCount * sizeof(LevelEnemy)) &&
+            h.doorCount < 0xFFFF;
+    for (uint32_t i = 0; i < h.doorCount && valid; i++)
+        valid = doors()[i].x < h.width && doors()[i].y < h.height;
+    if (valid && h.pvsOffset)
+        valid = h.pvsWordsPerSet == (tiles + 63) / 64 && fits(h.pvsOffset, tiles * 4) &&
+                fits(alignUp(h.pvsOffset + tiles * 4), (size_t)h.pvsSetCount * h.pvsWordsPerSet * 8);
+    if (valid && h.pvsOffset)
+        for (size_t i = 0; i < tiles && valid; i++)
+            valid = pvsTileSets()[i] < (int32_t)h.pvsSetCount;
+    if (!valid) {
+        std::cerr << "Not a level file (or wrong version): " << path << "\n";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedLevel::close()
+{
+#ifndef _WIN32
+    if (base)
+        munmap(const_cast<unsigned char*>(base), size);
+#endif
+    fallback.clear();
+    base = nullptr;
+    size = 0;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compiled level (.lvl): one file holding every layer of a level, laid out
+// so it can be mapped and used in place. Little endian, every section
+// starts on an 8 byte boundary:
+//
+//   LevelHeader
+//   walls, floors, ceilings   width * height uint16 tile ids each, row major
+//   lights                    width * height uint16 tile darkening, row major
+//   doors                     doorCount LevelDoor, in door slot order
+//   enemies                   enemyCount LevelEnemy
+//   pvs (optional)            width * height int32 set index (-1 = none),
+//                             then pvsSetCount sets of pvsWordsPerSet uint64
+//
+// Bump LEVEL_VERSION whenever the layout changes. Version 3: the PVS is the
+// exact sweep; version 2 files carry a sampled one that misses sightlines.
+constexpr uint32_t LEVEL_VERSION = 3;
+
+struct LevelHeader {
+    char magic[4];                 // "WLVL"
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t doorCount, enemyCount;
+    float playerX, playerY, playerAngle;
+    uint32_t wallsOffset, floorsOffset, ceilingsOffset, lightsOffset;
+    uint32_t doorsOffset, enemiesOffset;
+    uint32_t pvsOffset;            // 0 when the level has no baked PVS
+    uint32_t pvsSetCount, pvsWordsPerSet;
+    uint32_t fileSize;
+};
+
+struct LevelDoor {
+    uint16_t x, y;
+    uint8_t locked, keyType;       // keyType: 0 = none, 1 = blue, 2 = red, 3 = gold
+    uint16_t reserved;
+};
+
+struct LevelEnemy {
+    float x, y, angle;
+};
+
+// Door tiles 6-9 of the text maps: 6 opens freely, 7-9 need a key
+bool doorFromTile(int tile, int x, int y, LevelDoor& door);
+
+// Reads one tile layer of a text map. Rows written by mapEditor.py are
+// whitespace separated ids of any size; rows without whitespace (the
+// original hand-made maps) are one digit per tile. Rows may be ragged.
+bool readTextLayer(const char* path, std::vector<std::vector<int>>& rows);
+
+// Level in memory, as the converter builds it
+struct LevelData {
+    int width = 0, height = 0;
+    std::vector<uint16_t> walls, floors, ceilings, lights;
+    std::vector<LevelDoor> doors;
+    std::vector<LevelEnemy> enemies;
+    float playerX = 2.0f, playerY = 2.0f, playerAngle = 0.0f;
+    std::vector<int32_t> pvsTileSets;
+    std::vector<uint64_t> pvsSets;
+    int pvsWordsPerSet = 0;
+};
+
+// Builds a level from text files: the wall layer (map.txt), optional
+// floor/ceiling/light layers (floor.txt, ceil.txt, light.txt) and enemy
+// list ("x y" lines), and bakes its PVS. Any optional path may be null.
+bool levelFromText(LevelData& level, const char* wallsPath, const char* floorsPath,
+                   const char* ceilingsPath, const char* lightsPath, const char* enemiesPath);
+bool writeLevel(const char* path, const LevelData& level);
+
+// Read-only view of a compiled level file, mapped into memory
+class MappedLevel {
+public:
+    MappedLevel() = default;
+    ~MappedLevel() { close(); }
+    MappedLevel(const MappedLevel&) = delete;
+    MappedLevel& operator=(const MappedLevel&) = delete;
+
+    // Maps the file and checks the header and section bounds
+    bool open(const char* path);
+    void close();
+
+    const LevelHeader& header() const { return *reinterpret_cast<const LevelHeader*>(base); }
+    const uint16_t* walls() const { return section<uint16_t>(header().wallsOffset); }
+    const uint16_t* floors() const { return section<uint16_t>(header().floorsOffset); }
+    const uint16_t* ceilings() const { return section<uint16_t>(header().ceilingsOffset); }
+    const uint16_t* lights() const { return section<uint16_t>(header().lightsOffset); }
+    const LevelDoor* doors() const { return section<LevelDoor>(header().doorsOffset); }
+    const LevelEnemy* enemies() const { return section<LevelEnemy>(header().enemiesOffset); }
+    bool hasPvs() const { return header().pvsOffset != 0; }
+    const int32_t* pvsTileSets() const { return section<int32_t>(header().pvsOffset); }
+    const uint64_t* pvsSets() const {
+        const LevelHeader& h = header();
+        size_t tileBytes = ((size_t)h.width * h.height * sizeof(int32_t) + 7) & ~(size_t)7;
+        return section<uint64_t>(h.pvsOffset + (uint32_t)tileBytes);
+    }
+
+private:
+    const unsigned char* base = nullptr;
+    size_t size = 0;
+    std::vector<unsigned char> fallback;   // platforms without mmap read the file
+
+    template <typename T>
+    const T* section(uint32_t offset) const { return reinterpret_cast<const T*>(base + offset); }
+};
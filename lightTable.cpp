@@ -0,0 +1,28 @@
+#include "lightTable.hpp"
+
+void LightTable::build(uint32_t fogColour, int minBrightness, float fadeDistance)
+{
+    minBrightness = std::clamp(minBrightness, 0, 255);
+    levelsPerTile = fadeDistance > 0.0f ? (LEVELS - 1) / fadeDistance : 0.0f;
+    const uint32_t fogRed = (fogColour >> 16) & 0xFF, fogGreen = (fogColour >> 8) & 0xFF,
+                   fogBlue = fogColour & 0xFF;
+
+    for (int level = 0; level < LEVELS; level++) {
+        uint32_t keep = 255 - level * (255 - minBrightness) / (LEVELS - 1);
+        levelBrightness[level] = (uint8_t)keep;
+        Ramp& ramp = ramps[level];
+        for (uint32_t v = 0; v < 256; v++) {
+            ramp.red[v]   = (uint8_t)((v * keep + fogRed   * (255 - keep)) / 255);
+            ramp.green[v] = (uint8_t)((v * keep + fogGreen * (255 - keep)) / 255);
+            ramp.blue[v]  = (uint8_t)((v * keep + fogBlue  * (255 - keep)) / 255);
+        }
+    }
+}
+
+void LightTable::shadeSpan(uint32_t* pixels, int count, int level) const
+{
+    if (level == 0)
+        return;   // full brightness is the identity whatever the fog
+    for (int i = 0; i < count; i++)
+        pixels[i] = shade(pixels[i], level);
+}
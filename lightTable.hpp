@@ -0,0 +1,44 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+// Distance and per-tile shading as table lookups, after Doom's colormaps.
+// Textures are ARGB8888 rather than paletted, so instead of a palette remap
+// per light level each level keeps a 256 entry ramp per colour channel.
+// Level 0 is full brightness; the last level keeps minBrightness/255 of
+// the texel and fills the rest with the fog colour.
+class LightTable {
+public:
+    static constexpr int LEVELS = 32;
+
+    LightTable() { build(0x000000, 40, 8.0f); }
+
+    // fogColour is 0xRRGGBB. Distance fades from level 0 at the eye to the
+    // last level at fadeDistance tiles.
+    void build(uint32_t fogColour, int minBrightness, float fadeDistance);
+
+    // Level for a perpendicular view distance, made darker by a tile's
+    // light value (0 = no change, each step is one level darker)
+    int levelAt(float distance, int darken) const {
+        int level = (int)(std::min(distance * levelsPerTile, (float)LEVELS) + 0.5f) + darken;
+        return std::clamp(level, 0, LEVELS - 1);
+    }
+
+    uint32_t shade(uint32_t texel, int level) const {
+        const Ramp& ramp = ramps[level];
+        return 0xFF000000u | (uint32_t)ramp.red[(texel >> 16) & 0xFF] << 16 |
+               (uint32_t)ramp.green[(texel >> 8) & 0xFF] << 8 | ramp.blue[texel & 0xFF];
+    }
+    // Shades count pixels in place, all at one level
+    void shadeSpan(uint32_t* pixels, int count, int level) const;
+
+    // Grey level multiplier of a level, for SDL colour modulation on the
+    // renderer path (which cannot add fog)
+    uint8_t brightness(int level) const { return levelBrightness[level]; }
+
+private:
+    struct Ramp { uint8_t red[256], green[256], blue[256]; };
+    Ramp ramps[LEVELS];
+    uint8_t levelBrightness[LEVELS];
+    float levelsPerTile = 1.0f;
+};
@@ -1,42 +1,326 @@
 #include "WolfGame.hpp"
+#include "demo.hpp"
+#include "distanceField.hpp"
+#include "enemy.hpp"
+#include "enemySystem.hpp"
+#include "levelFile.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
 
 Game* game = nullptr;
 
+// Per-tick AI cost of heap-allocated Enemy objects against EnemySystem.
+// Both get the same spawns and seeds, so they should end in the same place.
+static void benchEnemies(int count, int ticks)
+{
+    const float dt = Game::TICK_SECONDS;
+    const std::pair<float, float> player = {0.0f, 0.0f};
+    std::vector<std::unique_ptr<Enemy>> objects;
+    EnemySystem system;
+    Rng spawn(12345);
+    for (int i = 0; i < count; i++) {
+        float x = spawn.nextFloat() * 60.0f - 30.0f, y = spawn.nextFloat() * 60.0f - 30.0f;
+        objects.push_back(std::make_unique<Enemy>(x, y, 0.0f));
+        objects.back()->init();
+        objects.back()->seedRandom(1, i + 1);
+        objects.back()->alert();
+        system.add(x, y, 0.0f);
+        system.seedRandom(i, 1, i + 1);
+        system.alert(i);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    for (int t = 0; t < ticks; t++)
+        for (int i = 0; i < count; i++) {
+            objects[i]->_process(dt, player);
+            objects[i]->updateCanSeePlayer(i % 2 == 0);
+            objects[i]->clearDamageThisFrame();
+        }
+    double objectMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (int t = 0; t < ticks; t++)
+        for (int i = 0; i < count; i++) {
+            system.process(i, dt, player.first, player.second);
+            system.setCanSeePlayer(i, i % 2 == 0);
+            system.takeDamageDealt(i);
+        }
+    double systemMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    int mismatched = 0;
+    for (int i = 0; i < count; i++)
+        if (objects[i]->get_position() != system.position(i))
+            mismatched++;
+
+    std::cout << count << " enemies, " << ticks << " ticks\n"
+              << "  Enemy objects: " << objectMs / ticks << " ms/tick\n"
+              << "  EnemySystem:   " << systemMs / ticks << " ms/tick ("
+              << objectMs / systemMs << "x)\n"
+              << "  final positions " << (mismatched ? "differ for " + std::to_string(mismatched) + " enemies" : "match") << "\n";
+}
+
+// Tile crossings and tile reads of bench rays
+struct BenchWalk {
+    long long crossings = 0, reads = 0;
+};
+
+// Walks one ray from (ox, oy) to the first solid tile and adds its work to
+// walk: every tile boundary crossed, jumped or stepped, and every tile
+// read (the field at the start of a jump and the hit test after a step).
+// field == nullptr steps every tile.
+static void castBenchRay(const TileGrid& map, const DistanceField* field, float ox, float oy,
+                         float dx, float dy, int& hitX, int& hitY, BenchWalk& walk)
+{
+    int mapX = (int)ox, mapY = (int)oy;
+    int stepX = dx < 0 ? -1 : 1, stepY = dy < 0 ? -1 : 1;
+    float deltaDistX = dx == 0 ? 1e30f : std::abs(1.0f / dx);
+    float deltaDistY = dy == 0 ? 1e30f : std::abs(1.0f / dy);
+    float sideDistX = (dx < 0 ? ox - mapX : mapX + 1.0f - ox) * deltaDistX;
+    float sideDistY = (dy < 0 ? oy - mapY : mapY + 1.0f - oy) * deltaDistY;
+    while (true) {
+        if (field) {
+            int fromX = mapX, fromY = mapY;
+            if (field->jump(mapX, mapY, sideDistX, sideDistY, deltaDistX, deltaDistY, stepX, stepY))
+                walk.crossings += std::abs(mapX - fromX) + std::abs(mapY - fromY);
+            walk.reads++;
+        }
+        if (sideDistX < sideDistY) {
+            sideDistX += deltaDistX;
+            mapX += stepX;
+        } else {
+            sideDistY += deltaDistY;
+            mapY += stepY;
+        }
+        walk.crossings++;
+        walk.reads++;
+        if (field ? field->at(mapX, mapY) == 0 : map.at(mapX, mapY) != 0)
+            break;
+    }
+    hitX = mapX;
+    hitY = mapY;
+}
+
+// Time per ray with and without the distance field: from the centre of
+// every open tile of a text map, a fan of 360 rays plus rays aimed
+// exactly at the corners of the tiles around it (diagonals included) and
+// along the axes, where the walk has to break ties between crossings.
+// Both walks must hit the same wall tile. Wall time is the measure; the
+// crossing and tile read counts show where it goes, a jump still taking
+// each of its crossings.
+static void benchDda(const char* path)
+{
+    std::vector<std::vector<int>> rows;
+    if (!readTextLayer(path, rows))
+        return;
+    size_t width = 0;
+    for (const std::vector<int>& row : rows)
+        width = std::max(width, row.size());
+    std::vector<TileGrid::Tile> tiles(rows.size() * width, 0);
+    for (size_t y = 0; y < rows.size(); y++)
+        for (size_t x = 0; x < rows[y].size(); x++)
+            tiles[y * width + x] = (TileGrid::Tile)rows[y][x];
+    TileGrid map;
+    map.resize((int)width, (int)rows.size());
+    map.assignRows(tiles.data());
+    DistanceField field;
+    field.build(map);
+
+    const int directions = 360;
+    std::vector<std::pair<float, float>> rayDirs;
+    for (int r = 0; r < directions; r++) {
+        float a = 2.0f * 3.14159265f * (r + 0.5f) / directions;
+        rayDirs.push_back({std::cos(a), std::sin(a)});
+    }
+    for (int j = -3; j <= 4; j++)
+        for (int i = -3; i <= 4; i++) {
+            float dx = i - 0.5f, dy = j - 0.5f, length = std::hypot(dx, dy);
+            rayDirs.push_back({dx / length, dy / length});
+        }
+    rayDirs.insert(rayDirs.end(), {{1.0f, 0.0f}, {-1.0f, 0.0f}, {0.0f, 1.0f}, {0.0f, -1.0f}});
+    using Clock = std::chrono::steady_clock;
+    long long rays = 0, mismatched = 0;
+    BenchWalk walks[2];
+    double ms[2] = {0.0, 0.0};
+    std::vector<int> hits;
+    for (int pass = 0; pass < 2; pass++) {
+        Clock::time_point start = Clock::now();
+        size_t hit = 0;
+        for (int y = 0; y < map.height(); y++)
+            for (int x = 0; x < map.width(); x++) {
+                if (map.at(x, y) != 0)
+                    continue;
+                for (const std::pair<float, float>& dir : rayDirs) {
+                    int hitX, hitY;
+                    castBenchRay(map, pass ? &field : nullptr, x + 0.5f, y + 0.5f,
+                                 dir.first, dir.second, hitX, hitY, walks[pass]);
+                    int key = map.index(hitX, hitY);
+                    if (pass == 0) {
+                        hits.push_back(key);
+                        rays++;
+                    }
+                    else if (hits[hit++] != key)
+                        mismatched++;
+                }
+            }
+        ms[pass] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::cout << path << ": " << map.width() << "x" << map.height() << ", " << rays << " rays\n";
+    const char* names[2] = {"DDA:           ", "distance field:"};
+    for (int pass = 0; pass < 2; pass++)
+        std::cout << "  " << names[pass] << " " << ms[pass] * 1e6 / rays << " ns/ray (" << ms[pass] << " ms), "
+                  << (double)walks[pass].crossings / rays << " crossings/ray, "
+                  << (double)walks[pass].reads / rays << " tile reads/ray\n";
+    std::cout << "  speedup " << ms[0] / ms[1] << "x\n"
+              << "  wall hits " << (mismatched ? "differ for " + std::to_string(mismatched) + " rays" : "match") << "\n";
+}
+
+// -convert-level walls.txt out.lvl [-floor f.txt] [-ceil c.txt]
+// [-light l.txt] [-enemies e.txt] [-start x y angle]: compile text maps into a .lvl
+static int convertLevel(int argc, char* argv[], const char* wallsPath, const char* outPath)
+{
+    const char* floorsPath = nullptr;
+    const char* ceilingsPath = nullptr;
+    const char* lightsPath = nullptr;
+    const char* enemiesPath = nullptr;
+    LevelData level;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-floor") == 0 && i + 1 < argc)
+            floorsPath = argv[++i];
+        else if (strcmp(argv[i], "-ceil") == 0 && i + 1 < argc)
+            ceilingsPath = argv[++i];
+        else if (strcmp(argv[i], "-light") == 0 && i + 1 < argc)
+            lightsPath = argv[++i];
+        else if (strcmp(argv[i], "-enemies") == 0 && i + 1 < argc)
+            enemiesPath = argv[++i];
+        else if (strcmp(argv[i], "-start") == 0 && i + 3 < argc) {
+            level.playerX = (float)atof(argv[++i]);
+            level.playerY = (float)atof(argv[++i]);
+            level.playerAngle = (float)atof(argv[++i]);
+        }
+    }
+
+    if (!levelFromText(level, wallsPath, floorsPath, ceilingsPath, lightsPath, enemiesPath)
+        || !writeLevel(outPath, level))
+        return 1;
+    std::cout << "Wrote " << outPath << ": " << level.width << "x" << level.height << ", "
+              << level.doors.size() << " doors, " << level.enemies.size() << " enemies\n";
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        // -bench-enemies N: AI benchmark only, no window
+        if (strcmp(argv[i], "-bench-enemies") == 0 && i + 1 < argc) {
+            benchEnemies(atoi(argv[i + 1]), 700);
+            return 0;
+        }
+        // -bench-dda [map.txt]: DDA time per ray with and without the distance field
+        if (strcmp(argv[i], "-bench-dda") == 0) {
+            benchDda(i + 1 < argc ? argv[i + 1] : "map.txt");
+            return 0;
+        }
+        if (strcmp(argv[i], "-convert-level") == 0 && i + 2 < argc)
+            return convertLevel(argc, argv, argv[i + 1], argv[i + 2]);
+    }
+
     game = new Game();
-    game->addEnemy(5.0f,5.0f,0.0f);
+    const char* recordPath = nullptr;     // -record file: save this session's input
+    const char* timedemoPath = nullptr;   // -timedemo file: replay uncapped and time it
+    const char* levelPath = nullptr;      // -level file.lvl: compiled level instead of testMap.txt
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+            game->setWorkerCount(atoi(argv[++i]));
+        else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (strcmp(argv[i], "-timedemo") == 0 && i + 1 < argc)
+            timedemoPath = argv[++i];
+        else if (strcmp(argv[i], "-level") == 0 && i + 1 < argc)
+            levelPath = argv[++i];
+        else if (strcmp(argv[i], "-profile") == 0)
+            game->setProfilerOverlay(true);
+        else if (strcmp(argv[i], "-profile-csv") == 0 && i + 1 < argc)
+            game->setProfileCsv(argv[++i]);
+        else if (strcmp(argv[i], "-asset-timing") == 0)
+            game->setAssetTimingReport(true);
+        else if (strcmp(argv[i], "-dynres") == 0 && i + 1 < argc)   // -dynres budgetMs
+            game->setDynamicResolution(true, (float)atof(argv[++i]));
+        else if (strcmp(argv[i], "-fog") == 0 && i + 1 < argc)   // -fog RRGGBB
+            game->setFog((uint32_t)strtoul(argv[++i], nullptr, 16));
+    }
+
+    Demo demo;
+    if (timedemoPath && !demo.load(timedemoPath)) {
+        delete game;
+        return 1;
+    }
+    if (recordPath)
+        demo.seed = (uint64_t)time(nullptr);
+    game->setRandomSeed(demo.seed);
+
     game->init("My Game", 100, 100, 800, 600, false);
-    game->placePlayerAt(2, 2, 0.0f);
-    game->loadMapDataFromFile("testMap.txt");
+    if (levelPath) {
+        if (!game->loadLevel(levelPath)) {
+            delete game;
+            return 1;
+        }
+    }
+    else {
+        game->addEnemy(5.0f,5.0f,0.0f);
+        game->placePlayerAt(2, 2, 0.0f);
+        game->loadMapDataFromFile("testMap.txt");
+    }
     game->loadAllTextures("textureMapping.txt");
     game->loadEnemyTextures("enemyFrames.txt");
 
-    const int FPS = 60;
-    const float frameDelay = 1000.0f / FPS;
+    if (timedemoPath) {
+        FrameStats stats;
+        const double ticksToMs = 1000.0 / SDL_GetPerformanceFrequency();
+        for (size_t frame = 0; frame < demo.frames.size() && game->running(); frame++) {
+            Uint64 frameStart = SDL_GetPerformanceCounter();
 
-    Uint32 lastTicks = SDL_GetTicks();
+            game->pollInput();   // only for window close, the demo drives the game
+            game->applyInput(demo.frames[frame]);
+            game->advance(demo.frames[frame].deltaTime);
+            game->render();
 
-    while (game->running()) {
-        Uint32 frameStart = SDL_GetTicks();
+            stats.add((SDL_GetPerformanceCounter() - frameStart) * ticksToMs);
+        }
+        stats.report();
+        delete game;
+        return 0;
+    }
 
+    // Uncapped: the simulation ticks at a fixed rate inside advance(),
+    // rendering runs as fast as it can and interpolates between ticks
+    const double ticksToSeconds = 1.0 / SDL_GetPerformanceFrequency();
+    Uint64 lastCounter = SDL_GetPerformanceCounter();
+
+    while (game->running()) {
         // Delta Time calculation
-        Uint32 currentTicks = frameStart;
-        float deltaTime = (currentTicks - lastTicks) / 1000.0f;  
-        lastTicks = currentTicks;
+        Uint64 counter = SDL_GetPerformanceCounter();
+        float deltaTime = (float)((counter - lastCounter) * ticksToSeconds);
+        lastCounter = counter;
 
         // Game Loop 
-        game->handleEvents();
-        game->update(deltaTime);   
+        InputFrame input = game->pollInput();
+        input.deltaTime = deltaTime;
+        if (recordPath)
+            demo.frames.push_back(input);
+        game->applyInput(input);
+        game->advance(deltaTime);
         game->render();
-
-        // Frame Limiter 
-        Uint32 frameTime = SDL_GetTicks() - frameStart;
-        
-        if (frameTime < frameDelay) {
-            SDL_Delay(frameDelay - frameTime);
-        }
     }
 
+    if (recordPath)
+        demo.save(recordPath);
+
     delete game;
     return 0;
 }
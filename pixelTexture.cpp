@@ -0,0 +1,158 @@
+#include "pixelTexture.hpp"
+#include <algorithm>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Texel (u, v) are texture-space coordinates, u = x * width.
+static void drawTexturedSpanScalar(uint32_t* dst, int count, const PixelTexture& tex,
+                                   float u0, float v0, float du, float dv)
+{
+    const int w = tex.width, h = tex.height;
+    for (int i = 0; i < count; i++) {
+        int tx = (int)(u0 + i * du) % w;
+        int ty = (int)(v0 + i * dv) % h;
+        if (tx < 0) tx += w;
+        if (ty < 0) ty += h;
+        dst[i] = tex.pixels[ty * w + tx];
+    }
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+static int log2i(int v)
+{
+    int s = 0;
+    while ((1 << s) < v) s++;
+    return s;
+}
+#endif
+
+#if defined(__AVX2__)
+static int drawTexturedSpanSimd(uint32_t* dst, int count, const PixelTexture& tex,
+                                float u0, float v0, float du, float dv)
+{
+    const __m256 lane  = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 u0v   = _mm256_set1_ps(u0), v0v = _mm256_set1_ps(v0);
+    const __m256 duv   = _mm256_set1_ps(du), dvv = _mm256_set1_ps(dv);
+    const __m256i maskU = _mm256_set1_epi32(tex.width - 1);
+    const __m256i maskV = _mm256_set1_epi32(tex.height - 1);
+    const __m128i shift = _mm_cvtsi32_si128(log2i(tex.width));
+    const int* texels = reinterpret_cast<const int*>(tex.pixels.data());
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 idx = _mm256_add_ps(_mm256_set1_ps((float)i), lane);
+        __m256i tu = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_add_ps(u0v, _mm256_mul_ps(idx, duv))), maskU);
+        __m256i tv = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_add_ps(v0v, _mm256_mul_ps(idx, dvv))), maskV);
+        __m256i offset = _mm256_add_epi32(_mm256_sll_epi32(tv, shift), tu);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_i32gather_epi32(texels, offset, 4));
+    }
+    return i;
+}
+#elif defined(__SSE2__)
+static int drawTexturedSpanSimd(uint32_t* dst, int count, const PixelTexture& tex,
+                                float u0, float v0, float du, float dv)
+{
+    const __m128 lane  = _mm_setr_ps(0, 1, 2, 3);
+    const __m128 u0v   = _mm_set1_ps(u0), v0v = _mm_set1_ps(v0);
+    const __m128 duv   = _mm_set1_ps(du), dvv = _mm_set1_ps(dv);
+    const __m128i maskU = _mm_set1_epi32(tex.width - 1);
+    const __m128i maskV = _mm_set1_epi32(tex.height - 1);
+    const __m128i shift = _mm_cvtsi32_si128(log2i(tex.width));
+    const uint32_t* texels = tex.pixels.data();
+
+    alignas(16) int32_t offsets[4];
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 idx = _mm_add_ps(_mm_set1_ps((float)i), lane);
+        __m128i tu = _mm_and_si128(_mm_cvttps_epi32(_mm_add_ps(u0v, _mm_mul_ps(idx, duv))), maskU);
+        __m128i tv = _mm_and_si128(_mm_cvttps_epi32(_mm_add_ps(v0v, _mm_mul_ps(idx, dvv))), maskV);
+        _mm_store_si128(reinterpret_cast<__m128i*>(offsets),
+                        _mm_add_epi32(_mm_sll_epi32(tv, shift), tu));
+        // SSE2 has no gather, the four loads stay scalar
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm_setr_epi32((int)texels[offsets[0]], (int)texels[offsets[1]],
+                                        (int)texels[offsets[2]], (int)texels[offsets[3]]));
+    }
+    return i;
+}
+#endif
+
+void drawTexturedSpan(uint32_t* dst, int count, const PixelTexture& tex,
+                      float x, float y, float stepX, float stepY)
+{
+    float u0 = x * tex.width, v0 = y * tex.height;
+    float du = stepX * tex.width, dv = stepY * tex.height;
+    int done = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    if (tex.isPowerOfTwo())
+        done = drawTexturedSpanSimd(dst, count, tex, u0, v0, du, dv);
+#endif
+    drawTexturedSpanScalar(dst + done, count - done, tex,
+                           u0 + done * du, v0 + done * dv, du, dv);
+}
+
+void PixelTexture::buildMips()
+{
+    mips.clear();
+    const PixelTexture* src = this;
+    while (src->width > 1 && src->height > 1) {
+        PixelTexture level;
+        level.width = src->width / 2;
+        level.height = src->height / 2;
+        level.pixels.resize((size_t)level.width * level.height);
+        for (int y = 0; y < level.height; y++)
+            for (int x = 0; x < level.width; x++) {
+                uint32_t r = 0, g = 0, b = 0, opaque = 0;
+                for (int i = 0; i < 4; i++) {
+                    uint32_t texel = src->pixels[(size_t)(y * 2 + i / 2) * src->width + x * 2 + i % 2];
+                    if ((texel >> 24) == 0)
+                        continue;
+                    r += (texel >> 16) & 0xFF;
+                    g += (texel >> 8) & 0xFF;
+                    b += texel & 0xFF;
+                    opaque++;
+                }
+                level.pixels[(size_t)y * level.width + x] = opaque < 2 ? 0u :
+                    0xFF000000u | (r / opaque) << 16 | (g / opaque) << 8 | (b / opaque);
+            }
+        mips.push_back(std::move(level));
+        src = &mips.back();
+    }
+}
+
+std::vector<AtlasRect> packAtlas(const std::vector<const PixelTexture*>& images,
+                                 PixelTexture& atlas, int maxWidth)
+{
+    const int padding = 1;
+    std::vector<AtlasRect> rects(images.size());
+
+    // Shelf packing in submission order; sprite frames are all about
+    // the same size, so rows come out nearly full
+    int x = 0, y = 0, shelfHeight = 0, width = 0;
+    for (size_t i = 0; i < images.size(); i++) {
+        int w = images[i]->width, h = images[i]->height;
+        if (x > 0 && x + w > maxWidth) {
+            x = 0;
+            y += shelfHeight + padding;
+            shelfHeight = 0;
+        }
+        rects[i] = {x, y, w, h};
+        x += w + padding;
+        shelfHeight = std::max(shelfHeight, h);
+        width = std::max(width, x - padding);
+    }
+
+    atlas.width  = width;
+    atlas.height = y + shelfHeight;
+    atlas.pixels.assign((size_t)atlas.width * atlas.height, 0);
+    for (size_t i = 0; i < images.size(); i++) {
+        const PixelTexture& img = *images[i];
+        for (int row = 0; row < img.height; row++)
+            std::copy(img.pixels.begin() + (size_t)row * img.width,
+                      img.pixels.begin() + (size_t)(row + 1) * img.width,
+                      atlas.pixels.begin() + (size_t)(rects[i].y + row) * atlas.width + rects[i].x);
+    }
+    return rects;
+}
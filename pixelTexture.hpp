@@ -0,0 +1,55 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Decoded ARGB8888 copy of an image, sampled by the framebuffer renderer.
+struct PixelTexture {
+    int width = 0, height = 0;
+    std::vector<uint32_t> pixels;   // row-major, width * height
+    std::vector<PixelTexture> mips; // level 1 (half size) and down, see buildMips
+
+    bool isPowerOfTwo() const {
+        return width > 0 && height > 0 &&
+               (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+    }
+
+    // Box-filtered mip chain down to one pixel on the short side. Alpha
+    // stays 0 or 255 so alpha-tested sprites keep working at every level:
+    // a texel is opaque if at least half its source texels are, and takes
+    // the average colour of those.
+    void buildMips();
+    // Level 0 is this texture; levels past the end clamp to the smallest
+    const PixelTexture& mip(int level) const {
+        if (level <= 0 || mips.empty())
+            return *this;
+        return mips[std::min(level, (int)mips.size()) - 1];
+    }
+    // Smallest level still at least projectedHeight texels tall, so a
+    // column of that many pixels reads each texel about once
+    int mipLevelFor(int projectedHeight) const {
+        int level = 0;
+        while (level < (int)mips.size() && mips[level].height >= projectedHeight)
+            level++;
+        return level;
+    }
+};
+
+// Placement of one image inside a texture atlas, in atlas pixels
+struct AtlasRect {
+    int x = 0, y = 0, w = 0, h = 0;
+};
+
+// Packs images into rows of an atlas at most maxWidth wide, with one
+// transparent pixel between neighbours so nearest sampling at a frame's
+// edge never picks up the next frame. Returns one rect per image.
+std::vector<AtlasRect> packAtlas(const std::vector<const PixelTexture*>& images,
+                                 PixelTexture& atlas, int maxWidth = 2048);
+
+// Fills count pixels of dst with texels of tex, sampled at world
+// position (x, y) and advancing by (stepX, stepY) per pixel. One world
+// unit covers the whole texture, which repeats every tile.
+// Uses AVX2 (8 pixels) or SSE2 (4 pixels) when the build enables them
+// and the texture has power-of-two sides, scalar code otherwise.
+void drawTexturedSpan(uint32_t* dst, int count, const PixelTexture& tex,
+                      float x, float y, float stepX, float stepY);
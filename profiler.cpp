@@ -0,0 +1,57 @@
+#include "profiler.hpp"
+#include <iostream>
+
+const char* profileZoneName(int zone)
+{
+    static const char* names[PROFILE_ZONE_COUNT] = {
+        "input", "player", "doors", "enemy_ai", "los", "walls",
+        "floor", "ceiling", "sprite_sort", "sprite_draw", "present"
+    };
+    return zone >= 0 && zone < PROFILE_ZONE_COUNT ? names[zone] : "?";
+}
+
+void FrameProfiler::endFrame()
+{
+    Clock::time_point now = Clock::now();
+    uint64_t index = published.load(std::memory_order_relaxed);
+
+    ProfileFrame& f = ring[index % HISTORY];
+    f.index = index;
+    f.totalMs = std::chrono::duration<float, std::milli>(now - frameStart).count();
+    for (int z = 0; z < PROFILE_ZONE_COUNT; z++)
+        f.zoneMs[z] = current[z].exchange(0, std::memory_order_relaxed) / 1.0e6f;
+    frameStart = now;
+
+    // The slot is complete before the count moves past it
+    published.store(index + 1, std::memory_order_release);
+
+    if (csv.is_open()) {
+        csv << f.index << ',' << f.totalMs;
+        for (int z = 0; z < PROFILE_ZONE_COUNT; z++)
+            csv << ',' << f.zoneMs[z];
+        csv << '\n';
+    }
+}
+
+bool FrameProfiler::frame(int age, ProfileFrame& out) const
+{
+    uint64_t count = published.load(std::memory_order_acquire);
+    if (age < 0 || age >= HISTORY || (uint64_t)age >= count)
+        return false;
+    out = ring[(count - 1 - age) % HISTORY];
+    return true;
+}
+
+bool FrameProfiler::openCsv(const char* path)
+{
+    csv.open(path);
+    if (!csv.is_open()) {
+        std::cerr << "Failed to open profile CSV: " << path << "\n";
+        return false;
+    }
+    csv << "frame,total_ms";
+    for (int z = 0; z < PROFILE_ZONE_COUNT; z++)
+        csv << ',' << profileZoneName(z) << "_ms";
+    csv << '\n';
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+
+// Subsystems timed every frame. Zones do not nest, so they add up to the
+// busy part of a frame; the rest of the frame total is idle/frame cap.
+enum ProfileZone {
+    PROFILE_INPUT,
+    PROFILE_PLAYER,
+    PROFILE_DOORS,
+    PROFILE_ENEMY_AI,
+    PROFILE_LOS,
+    PROFILE_WALLS,
+    PROFILE_FLOOR,
+    PROFILE_CEILING,
+    PROFILE_SPRITE_SORT,
+    PROFILE_SPRITE_DRAW,
+    PROFILE_PRESENT,
+    PROFILE_ZONE_COUNT
+};
+
+const char* profileZoneName(int zone);
+
+struct ProfileFrame {
+    uint64_t index = 0;
+    float totalMs = 0.0f;                  // time since the previous frame ended
+    float zoneMs[PROFILE_ZONE_COUNT] = {};
+};
+
+// Collects zone times for the frame in flight and keeps the last HISTORY
+// frames in a ring buffer. add() may be called from any thread; endFrame()
+// and the readers belong to the main thread. Nothing takes a lock.
+class FrameProfiler {
+public:
+    static constexpr int HISTORY = 256;
+    using Clock = std::chrono::steady_clock;
+
+    void add(ProfileZone zone, Clock::duration elapsed) {
+        current[zone].fetch_add(
+            (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+            std::memory_order_relaxed);
+    }
+
+    // Publishes the frame in flight to the ring (and CSV) and starts the next
+    void endFrame();
+
+    // Number of frames published so far
+    uint64_t frameCount() const { return published.load(std::memory_order_acquire); }
+    // age 0 is the newest frame; false once age reaches the stored history
+    bool frame(int age, ProfileFrame& out) const;
+
+    // Appends one row per frame from now on
+    bool openCsv(const char* path);
+
+private:
+    std::atomic<uint64_t> current[PROFILE_ZONE_COUNT] = {};
+    ProfileFrame ring[HISTORY];
+    std::atomic<uint64_t> published{0};
+    Clock::time_point frameStart = Clock::now();
+    std::ofstream csv;
+};
+
+// Adds the lifetime of the scope to a zone
+class ProfileScope {
+public:
+    ProfileScope(FrameProfiler& profiler, ProfileZone zone)
+        : profiler(profiler), zone(zone), start(FrameProfiler::Clock::now()) {}
+    ~ProfileScope() { profiler.add(zone, FrameProfiler::Clock::now() - start); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfiler& profiler;
+    ProfileZone zone;
+    FrameProfiler::Clock::time_point start;
+};
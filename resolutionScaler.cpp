@@ -0,0 +1,46 @@
+#include "resolutionScaler.hpp"
+
+void ResolutionScaler::reset()
+{
+    // Hold off at first too: the first frames carry loading hitches
+    step = 0;
+    averageMs = 0.0f;
+    overFrames = underFrames = 0;
+    holdFrames = FRAMES_TO_HOLD;
+}
+
+bool ResolutionScaler::addFrame(float ms)
+{
+    if (holdFrames > 0) {
+        holdFrames--;
+        return false;
+    }
+    averageMs = averageMs == 0.0f ? ms : averageMs + (ms - averageMs) * 0.1f;
+
+    if (averageMs > budgetMs) {
+        overFrames++;
+        underFrames = 0;
+    }
+    else if (averageMs < budgetMs * HEADROOM) {
+        underFrames++;
+        overFrames = 0;
+    }
+    else
+        overFrames = underFrames = 0;
+
+    int next = step;
+    if (overFrames >= FRAMES_TO_DROP && step < STEPS - 1)
+        next = step + 1;
+    else if (underFrames >= FRAMES_TO_RAISE && step > 0)
+        next = step - 1;
+    if (next == step)
+        return false;
+
+    // Frame times at the old size say nothing about the new one, and the
+    // first few at the new size still carry the switch
+    step = next;
+    averageMs = 0.0f;
+    overFrames = underFrames = 0;
+    holdFrames = FRAMES_TO_HOLD;
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Picks the render scale of the 3D view from measured frame times so that
+// frames stay inside a time budget. It steps down quickly once the average
+// frame is over budget and steps back up only after a long run with clear
+// headroom, holding each new size for a while before judging it, so it
+// does not flip between two sizes.
+class ResolutionScaler {
+public:
+    static constexpr int STEPS = 6;              // 100% down to 50% in 10% steps
+    static constexpr float HEADROOM = 0.75f;     // step up below this share of the budget
+    static constexpr int FRAMES_TO_DROP = 5, FRAMES_TO_RAISE = 60, FRAMES_TO_HOLD = 20;
+
+    void setBudget(float ms) { budgetMs = ms; }
+    float budget() const { return budgetMs; }
+    void reset();
+
+    // Feeds one frame time; returns true when scale() changed
+    bool addFrame(float ms);
+    float scale() const { return 1.0f - step * 0.1f; }
+
+private:
+    float budgetMs = 1000.0f / 60.0f;
+    float averageMs = 0.0f;   // moving average, 0 until the first frame at this size
+    int step = 0;
+    int overFrames = 0, underFrames = 0, holdFrames = FRAMES_TO_HOLD;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+// Small seeded random generator (PCG32). Unlike rand() its sequence is the
+// same on every platform and each instance is independent, which is what
+// deterministic demo playback needs.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 1, uint64_t stream = 0) { seedWith(seed, stream); }
+
+    void seedWith(uint64_t seed, uint64_t stream = 0) {
+        state = 0;
+        increment = (stream << 1) | 1;
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    // Uniform in [0, n); 0 when n <= 0
+    int nextInt(int n) { return n > 0 ? (int)(next() % (uint32_t)n) : 0; }
+
+    // Uniform in [0, 1]
+    float nextFloat() { return next() / 4294967295.0f; }
+
+    // 1 in n chance; never for n <= 0
+    bool oneIn(int n) { return n > 0 && nextInt(n) == 0; }
+
+private:
+    uint64_t state = 0, increment = 1;
+};
@@ -0,0 +1,40 @@
+#include "tileGrid.hpp"
+#include <map>
+#include <mutex>
+
+// Shared chunks live for the whole run: there is one per value any grid
+// has held uniformly, and they are never written.
+const uint16_t* TileChunks::uniformChunk(uint16_t value)
+{
+    static std::mutex mutex;
+    static std::map<uint16_t, Chunk> chunks;
+    std::lock_guard<std::mutex> lock(mutex);
+    Chunk& chunk = chunks[value];
+    if (!chunk) {
+        chunk.reset(new uint16_t[CHUNK_AREA]);
+        std::fill(chunk.get(), chunk.get() + CHUNK_AREA, value);
+    }
+    return chunk.get();
+}
+
+void TileChunks::set(int x, int y, uint16_t value)
+{
+    size_t c = (size_t)(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT);
+    int offset = ((y & CHUNK_MASK) << CHUNK_SHIFT) | (x & CHUNK_MASK);
+    if (!owned[c]) {
+        if (directory[c][offset] == value)
+            return;
+        owned[c].reset(new uint16_t[CHUNK_AREA]);
+        std::copy(directory[c], directory[c] + CHUNK_AREA, owned[c].get());
+        directory[c] = owned[c].get();
+    }
+    owned[c][offset] = value;
+}
+
+size_t TileChunks::ownedChunkCount() const
+{
+    size_t count = 0;
+    for (const Chunk& chunk : owned)
+        count += chunk != nullptr;
+    return count;
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One 16-bit value per tile, held in CHUNK_SIZE square chunks that are
+// allocated on first write. A directory maps chunk coordinates to chunk
+// storage; chunks whose tiles all hold the same value (open space, solid
+// rock) point at one read-only chunk per value shared by every layer, so
+// memory follows the map's content rather than its area. A read is one
+// directory load and one chunk load.
+class TileChunks {
+public:
+    static constexpr int CHUNK_SHIFT = 5;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+    static constexpr int CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+
+    // Sizes for width x height values and fills them with valueAt(x, y)
+    template <typename Fn>
+    void build(int width, int height, Fn&& valueAt);
+
+    // Unchecked, 0 <= x < width and 0 <= y < height
+    uint16_t get(int x, int y) const {
+        return directory[(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT)]
+                        [((y & CHUNK_MASK) << CHUNK_SHIFT) | (x & CHUNK_MASK)];
+    }
+    // Unchecked; gives the chunk its own storage if it was shared
+    void set(int x, int y, uint16_t value);
+
+    size_t chunkCount() const { return directory.size(); }
+    size_t ownedChunkCount() const;
+
+private:
+    using Chunk = std::unique_ptr<uint16_t[]>;
+    static const uint16_t* uniformChunk(uint16_t value);
+
+    int chunksX = 0, chunksY = 0;
+    std::vector<const uint16_t*> directory;   // per chunk, owned or shared storage
+    std::vector<Chunk> owned;                 // per chunk, null while shared
+};
+
+template <typename Fn>
+void TileChunks::build(int width, int height, Fn&& valueAt)
+{
+    chunksX = (width + CHUNK_MASK) >> CHUNK_SHIFT;
+    chunksY = (height + CHUNK_MASK) >> CHUNK_SHIFT;
+    directory.assign((size_t)chunksX * chunksY, nullptr);
+    owned.clear();
+    owned.resize(directory.size());
+
+    // Gather each chunk and only keep storage for the mixed ones; tiles
+    // past the edge of the last chunk row/column read as 0
+    uint16_t values[CHUNK_AREA];
+    for (int cy = 0; cy < chunksY; cy++)
+        for (int cx = 0; cx < chunksX; cx++) {
+            bool uniform = true;
+            for (int y = 0; y < CHUNK_SIZE; y++)
+                for (int x = 0; x < CHUNK_SIZE; x++) {
+                    int tx = cx * CHUNK_SIZE + x, ty = cy * CHUNK_SIZE + y;
+                    uint16_t value = tx < width && ty < height ? valueAt(tx, ty) : 0;
+                    values[y * CHUNK_SIZE + x] = value;
+                    uniform = uniform && value == values[0];
+                }
+            size_t c = (size_t)cy * chunksX + cx;
+            if (uniform) {
+                directory[c] = uniformChunk(values[0]);
+            } else {
+                owned[c].reset(new uint16_t[CHUNK_AREA]);
+                std::copy(values, values + CHUNK_AREA, owned[c].get());
+                directory[c] = owned[c].get();
+            }
+        }
+}
+
+// Tile map with a one-tile solid border around the playable area.
+// Playable tiles are (0..width-1, 0..height-1); the border makes
+// (-1..width, -1..height) readable as well, so a ray or a collision probe
+// that leaves the map always stops on a wall instead of reading out of
+// bounds.
+// Next to each tile the grid keeps a door slot, so a ray that lands on a
+// door tile finds the door's entry in Game's dense door array in O(1).
+// Both are chunked (see TileChunks): an empty or solid 4096x4096 level
+// costs the directory and the border chunks.
+class TileGrid {
+public:
+    using Tile = uint16_t;
+    static constexpr Tile BORDER_TILE = 1;   // drawn with the first wall texture
+    // Widest and tallest map the loaders accept: index() is an int, so
+    // (MAX_SIDE + 2)^2 has to stay below 2^31
+    static constexpr int MAX_SIDE = 32768;
+
+    TileGrid() { resize(0, 0); }
+
+    // Discards the contents and makes an empty (all zero) width x height map
+    void resize(int width, int height) {
+        assign(width, height, [](int, int) { return (Tile)0; });
+    }
+    void clear() { resize(0, 0); }
+
+    int width() const { return w; }
+    int height() const { return h; }
+    bool empty() const { return w == 0 || h == 0; }
+
+    bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < w && y < h; }
+
+    // Unchecked access, valid for -1 <= x <= width and -1 <= y <= height
+    Tile at(int x, int y) const { return tiles.get(x + 1, y + 1); }
+
+    // Checked access, anything outside the map reads as border wall
+    Tile get(int x, int y) const {
+        if (x < -1 || y < -1 || x > w || y > h) return BORDER_TILE;
+        return at(x, y);
+    }
+    void set(int x, int y, Tile t) {
+        if (inBounds(x, y)) tiles.set(x + 1, y + 1, t);
+    }
+    // Replaces the playable area with width * height tiles in row order
+    void assignRows(const Tile* rows) {
+        int rowWidth = w;
+        assign(w, h, [rows, rowWidth](int x, int y) { return rows[(size_t)y * rowWidth + x]; });
+    }
+
+    // Dense key of a tile for per-tile bitmaps and lists, in
+    // [0, indexCount()); the tiles themselves live in chunks
+    int index(int x, int y) const { return (y + 1) * (w + 2) + (x + 1); }
+    int indexCount() const { return (w + 2) * (h + 2); }
+
+    // Index into the door array for the tile, -1 if none
+    int doorAt(int x, int y) const {
+        return (x < -1 || y < -1 || x > w || y > h) ? -1 : (int)doorSlots.get(x + 1, y + 1) - 1;
+    }
+    void setDoor(int x, int y, int door) {
+        if (inBounds(x, y)) doorSlots.set(x + 1, y + 1, (uint16_t)(door + 1));
+    }
+
+    // Bytes held in chunks of this grid's own, shared chunks excluded
+    size_t chunkBytes() const {
+        return (tiles.ownedChunkCount() + doorSlots.ownedChunkCount()) * TileChunks::CHUNK_AREA * sizeof(Tile);
+    }
+
+private:
+    // Sizes the grid and fills the playable area with tileAt(x, y)
+    template <typename Fn>
+    void assign(int width, int height, Fn tileAt) {
+        w = width;
+        h = height;
+        tiles.build(width + 2, height + 2, [&](int x, int y) {
+            if (x == 0 || y == 0 || x == width + 1 || y == height + 1)
+                return BORDER_TILE;
+            return (Tile)tileAt(x - 1, y - 1);
+        });
+        doorSlots.build(width + 2, height + 2, [](int, int) { return (uint16_t)0; });   // 0 = no door
+    }
+
+    int w = 0, h = 0;
+    TileChunks tiles, doorSlots;
+};
@@ -0,0 +1,324 @@
+#include "visibilitySet.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+// Tiles that stop sight for good; doors are left to the exact test
+static bool isOpaque(const TileGrid& map, int x, int y)
+{
+    return map.at(x, y) != 0 && map.doorAt(x, y) < 0;
+}
+
+// A line y = m * x + c of one octant's sweep, as a point of the (m, c)
+// plane. A convex polygon of them is a family of lines.
+struct SweepLine {
+    double m, c;
+};
+
+// Families of lines, their polygons stored back to back
+struct LineFamilies {
+    std::vector<SweepLine> lines;
+    std::vector<int> ends;   // one past each family's last line
+
+    int count() const { return (int)ends.size(); }
+    const SweepLine* begin(int f) const { return lines.data() + (f ? ends[f - 1] : 0); }
+    const SweepLine* end(int f) const { return lines.data() + ends[f]; }
+    void clear() { lines.clear(); ends.clear(); }
+};
+
+// Room left around tile edges for the rounding of the game's float DDA,
+// which can pass a hair on the other side of a corner than the exact line
+static constexpr double EDGE_SLACK = 1.0 / 64;
+// Families kept per column before they are merged into their hull
+static constexpr int MAX_FAMILIES = 16;
+
+// Appends to out the lines of polygon first..last with a * m + b * c <= d
+static void clip(const SweepLine* first, const SweepLine* last, double a, double b, double d,
+                 std::vector<SweepLine>& out)
+{
+    for (const SweepLine* p = first; p != last; p++) {
+        const SweepLine* q = p + 1 == last ? first : p + 1;
+        double fp = a * p->m + b * p->c - d, fq = a * q->m + b * q->c - d;
+        if (fp <= 0)
+            out.push_back(*p);
+        if ((fp < 0 && fq > 0) || (fp > 0 && fq < 0)) {
+            double t = fp / (fp - fq);
+            out.push_back({p->m + (q->m - p->m) * t, p->c + (q->c - p->c) * t});
+        }
+    }
+}
+
+// Replaces the families by the convex hull of all their lines, which
+// admits more lines, never fewer
+static void mergeFamilies(LineFamilies& families, std::vector<SweepLine>& points)
+{
+    points = families.lines;
+    std::sort(points.begin(), points.end(), [](const SweepLine& p, const SweepLine& q) {
+        return p.m < q.m || (p.m == q.m && p.c < q.c);
+    });
+    auto turn = [](const SweepLine& o, const SweepLine& p, const SweepLine& q) {
+        return (p.m - o.m) * (q.c - o.c) - (p.c - o.c) * (q.m - o.m);
+    };
+    std::vector<SweepLine>& hull = families.lines;
+    hull.resize(2 * points.size());
+    size_t k = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        while (k >= 2 && turn(hull[k - 2], hull[k - 1], points[i]) <= 0)
+            k--;
+        hull[k++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = k + 1; i-- > 0;) {
+        while (k >= lower && turn(hull[k - 2], hull[k - 1], points[i]) <= 0)
+            k--;
+        hull[k++] = points[i];
+    }
+    hull.resize(k > 1 ? k - 1 : k);
+    families.ends.assign(1, (int)hull.size());
+}
+
+// Sets bits first..last
+static void setBits(uint64_t* bits, int first, int last)
+{
+    int firstWord = first >> 6, lastWord = last >> 6;
+    uint64_t firstMask = ~0ull << (first & 63), lastMask = ~0ull >> (63 - (last & 63));
+    if (firstWord == lastWord) {
+        bits[firstWord] |= firstMask & lastMask;
+        return;
+    }
+    bits[firstWord] |= firstMask;
+    for (int word = firstWord + 1; word < lastWord; word++)
+        bits[word] = ~0ull;
+    bits[lastWord] |= lastMask;
+}
+
+// Transposes a 64 x 64 bit matrix held as 64 rows of bits, by swapping
+// ever smaller off-diagonal blocks
+static void transpose64(uint64_t* m)
+{
+    uint64_t mask = 0x00000000FFFFFFFFull;
+    for (int j = 32; j != 0; j >>= 1, mask ^= mask << j)
+        for (int k = 0; k < 64; k = (k + j + 1) & ~j) {
+            uint64_t t = ((m[k] >> j) ^ m[k + j]) & mask;
+            m[k] ^= t << j;
+            m[k + j] ^= t;
+        }
+}
+
+// Opacity of every tile and, per direction, how many tiles from each one
+// on share its opacity, so a sweep finds the open runs of a column without
+// walking them
+struct OpacityRuns {
+    int w, h;
+    std::vector<uint8_t> opaque;
+    std::vector<int> run[4];   // towards +x, -x, +y, -y
+
+    explicit OpacityRuns(const TileGrid& map) : w(map.width()), h(map.height()) {
+        opaque.resize((size_t)w * h);
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                opaque[y * w + x] = isOpaque(map, x, y);
+        for (std::vector<int>& r : run)
+            r.assign((size_t)w * h, 1);
+        for (int y = 0; y < h; y++) {
+            for (int x = w - 2; x >= 0; x--)
+                if (opaque[y * w + x] == opaque[y * w + x + 1])
+                    run[0][y * w + x] = run[0][y * w + x + 1] + 1;
+            for (int x = 1; x < w; x++)
+                if (opaque[y * w + x] == opaque[y * w + x - 1])
+                    run[1][y * w + x] = run[1][y * w + x - 1] + 1;
+        }
+        for (int y = h - 2; y >= 0; y--)
+            for (int x = 0; x < w; x++)
+                if (opaque[y * w + x] == opaque[(y + 1) * w + x])
+                    run[2][y * w + x] = run[2][(y + 1) * w + x] + 1;
+        for (int y = 1; y < h; y++)
+            for (int x = 0; x < w; x++)
+                if (opaque[y * w + x] == opaque[(y - 1) * w + x])
+                    run[3][y * w + x] = run[3][(y - 1) * w + x] + 1;
+    }
+};
+
+// Marks every tile that a line leaving tile (ax, ay) into one octant
+// reaches through open tiles. The sweep works in a frame where the source
+// is tile (0, 0) and the lines are y = m * x + c with 0 <= m <= 1: frame
+// tile (u, v) is map tile (ax + sx * u, ay + sy * v), with u and v swapped
+// when transposed. Column by column it keeps the families of lines that
+// crossed every column so far without entering an opaque tile, split where
+// a column has several open runs, and marks the tiles of the column they
+// reach. A sightline from any point of the source to any point of a target
+// lies on such a line, so no visible pair is ever left out.
+static void sweepOctant(const OpacityRuns& runs, int ax, int ay, int sx, int sy, bool transposed,
+                        uint64_t* bits)
+{
+    int w = runs.w;
+    auto tileAt = [&](int u, int v) {
+        int x = ax + sx * (transposed ? v : u), y = ay + sy * (transposed ? u : v);
+        return y * w + x;
+    };
+    // Runs along +v and -v, and the frame span of the map
+    const std::vector<int>& forward = runs.run[transposed ? (sx > 0 ? 0 : 1) : (sy > 0 ? 2 : 3)];
+    const std::vector<int>& backward = runs.run[transposed ? (sx > 0 ? 1 : 0) : (sy > 0 ? 3 : 2)];
+    int along = transposed ? ax : ay, alongSize = transposed ? runs.w : runs.h;
+    int alongStep = transposed ? sx : sy;
+    int vLow = alongStep > 0 ? -along : along - (alongSize - 1);
+    int vHigh = alongStep > 0 ? alongSize - 1 - along : along;
+    int across = transposed ? ay : ax, acrossSize = transposed ? runs.h : runs.w;
+    int uHigh = (transposed ? sy : sx) > 0 ? acrossSize - 1 - across : across;
+
+    // Every line through the source tile
+    LineFamilies families, next;
+    families.lines = {{0, -EDGE_SLACK}, {1, -1 - EDGE_SLACK}, {1, 1 + EDGE_SLACK}, {0, 1 + EDGE_SLACK}};
+    families.ends = {4};
+    std::vector<SweepLine> scratch;
+    std::vector<std::pair<int, int>> reached, spans;   // per family, tiles of the column
+    for (int u = 1; u <= uHigh && families.count() > 0; u++) {
+        // Tiles the lines reach in column u, from their heights entering
+        // and leaving it; families overlap, so the spans are merged first
+        reached.clear();
+        spans.clear();
+        for (int f = 0; f < families.count(); f++) {
+            double low = 1e30, high = -1e30;
+            for (const SweepLine* l = families.begin(f); l != families.end(f); l++) {
+                low = std::min(low, l->m * u + l->c);
+                high = std::max(high, l->m * (u + 1) + l->c);
+            }
+            reached.push_back({std::max((int)std::floor(low - EDGE_SLACK), vLow),
+                               std::min((int)std::floor(high + EDGE_SLACK), vHigh)});
+            if (reached.back().first <= reached.back().second)
+                spans.push_back(reached.back());
+        }
+        std::sort(spans.begin(), spans.end());
+        for (size_t i = 0; i < spans.size();) {
+            int spanBegin = spans[i].first, spanEnd = spans[i].second;
+            for (i++; i < spans.size() && spans[i].first <= spanEnd + 1; i++)
+                spanEnd = std::max(spanEnd, spans[i].second);
+            if (transposed) {   // a row of the map, one run of bits
+                int a = tileAt(u, spanBegin), b = tileAt(u, spanEnd);
+                setBits(bits, std::min(a, b), std::max(a, b));
+            }
+            else
+                for (int v = spanBegin; v <= spanEnd; v++) {
+                    int t = tileAt(u, v);
+                    bits[t >> 6] |= 1ull << (t & 63);
+                }
+        }
+
+        // The lines go on through each open run of the column they reach
+        next.clear();
+        for (int f = 0; f < families.count(); f++) {
+            int vBegin = reached[f].first, vEnd = reached[f].second;
+            for (int v = vBegin; v <= vEnd;) {
+                int t = tileAt(u, v);
+                if (runs.opaque[t]) {
+                    v += forward[t];
+                    continue;
+                }
+                int runBegin = v == vBegin ? v - (backward[t] - 1) : v;
+                int runEnd = v + forward[t];   // one past the run
+                scratch.clear();
+                clip(families.begin(f), families.end(f), -u, -1, EDGE_SLACK - runBegin, scratch);   // enter at or above runBegin
+                size_t first = next.lines.size();
+                clip(scratch.data(), scratch.data() + scratch.size(), u + 1, 1, runEnd + EDGE_SLACK, next.lines);   // leave at or below runEnd
+                if (next.lines.size() > first)
+                    next.ends.push_back((int)next.lines.size());
+                v = runEnd;
+            }
+        }
+        std::swap(families, next);
+        if (families.count() > MAX_FAMILIES)
+            mergeFamilies(families, scratch);
+    }
+}
+
+void VisibilitySet::clear()
+{
+    w = h = wordsPerSet = 0;
+    setOf.clear();
+    sets.clear();
+}
+
+void VisibilitySet::assign(int width, int height, const int32_t* tileSets,
+                           const uint64_t* setWords, int setCount)
+{
+    w = width;
+    h = height;
+    wordsPerSet = (int)(((size_t)w * h + 63) / 64);
+    setOf.assign(tileSets, tileSets + (size_t)w * h);
+    sets.assign(setWords, setWords + (size_t)setCount * wordsPerSet);
+}
+
+void VisibilitySet::build(const TileGrid& map, WorkerPool& workers)
+{
+    clear();
+    if (map.empty() || (size_t)map.width() * map.height() > MAX_BAKE_TILES)
+        return;
+    w = map.width();
+    h = map.height();
+    int tileCount = w * h;
+    wordsPerSet = (tileCount + 63) / 64;
+    std::vector<uint64_t> raw((size_t)tileCount * wordsPerSet, 0);
+
+    // Each open tile sweeps the eight octants around it. Its neighbours
+    // are added outright: there is no column or row between them to sweep.
+    OpacityRuns runs(map);
+    workers.parallelFor(tileCount, 16, [&](int begin, int end) {
+        for (int t = begin; t < end; t++) {
+            if (runs.opaque[t])
+                continue;
+            int x = t % w, y = t / w;
+            uint64_t* bits = raw.data() + (size_t)t * wordsPerSet;
+            for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, h - 1); ny++)
+                for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, w - 1); nx++) {
+                    int n = ny * w + nx;
+                    bits[n >> 6] |= 1ull << (n & 63);
+                }
+            for (int octant = 0; octant < 8; octant++)
+                sweepOctant(runs, x, y, octant & 1 ? -1 : 1, octant & 2 ? -1 : 1, (octant & 4) != 0, bits);
+        }
+    });
+
+    // Sight is symmetric and so are the sweeps, up to rounding; the union
+    // of both directions settles any pair they disagree on. It works on
+    // 64 x 64 blocks of the tile-pair matrix, each ORed with the transpose
+    // of its mirror: block (I, J) and its mirror (J, I) only touch word J
+    // of rows in I and word I of rows in J, so bands of I never write the
+    // same word.
+    workers.parallelFor(wordsPerSet, 1, [&](int begin, int end) {
+        uint64_t block[64], mirror[64];
+        for (int blockA = begin; blockA < end; blockA++)
+            for (int blockB = blockA; blockB < wordsPerSet; blockB++) {
+                auto word = [&](int row, int column) -> uint64_t& {
+                    return raw[(size_t)row * wordsPerSet + column];
+                };
+                int rowsA = std::min(64, tileCount - blockA * 64), rowsB = std::min(64, tileCount - blockB * 64);
+                for (int k = 0; k < 64; k++) {
+                    block[k] = k < rowsA ? word(blockA * 64 + k, blockB) : 0;
+                    mirror[k] = k < rowsB ? word(blockB * 64 + k, blockA) : 0;
+                }
+                transpose64(mirror);
+                for (int k = 0; k < 64; k++)
+                    block[k] |= mirror[k];
+                for (int k = 0; k < rowsA; k++)
+                    word(blockA * 64 + k, blockB) = block[k];
+                transpose64(block);
+                for (int k = 0; k < rowsB; k++)
+                    word(blockB * 64 + k, blockA) = block[k];
+            }
+    });
+
+    // Share identical sets
+    std::map<std::vector<uint64_t>, int> unique;
+    setOf.assign(tileCount, -1);
+    for (int t = 0; t < tileCount; t++) {
+        if (runs.opaque[t])
+            continue;
+        std::vector<uint64_t> key(raw.begin() + (size_t)t * wordsPerSet,
+                                  raw.begin() + (size_t)(t + 1) * wordsPerSet);
+        auto found = unique.find(key);
+        if (found == unique.end()) {
+            found = unique.emplace(std::move(key), (int)unique.size()).first;
+            sets.insert(sets.end(), found->first.begin(), found->first.end());
+        }
+        setOf[t] = found->second;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "tileGrid.hpp"
+#include "workerPool.hpp"
+
+// Tile-to-tile potentially visible set, baked once per map. For every open
+// tile it stores a bitset of the tiles some point of it can see, so a line
+// of sight test can be rejected in O(1) before walking the exact DDA.
+// The bake is conservative: it sweeps every straight line out of each tile
+// (see sweepOctant in visibilitySet.cpp), so a pair is only rejected when
+// no line between any points of the two tiles stays clear of walls.
+// Doors count as open while baking: a closed door only ever blocks more,
+// and the exact test still checks its state, so the set stays valid as
+// doors change. Tiles with identical sets (most of a room) share one copy.
+// A set holds a bit per tile of the map, so maps past MAX_BAKE_TILES get
+// an empty set that rejects nothing; callers that want a cheaper answer
+// there check empty() and fall back to their own test.
+class VisibilitySet {
+public:
+    static constexpr int MAX_BAKE_TILES = 128 * 128;
+    void build(const TileGrid& map, WorkerPool& workers);
+    void clear();
+
+    // false only when no point in tile (ax, ay) can see tile (bx, by).
+    // Tiles outside the map or inside walls are never rejected.
+    bool mayBeVisible(int ax, int ay, int bx, int by) const {
+        if ((unsigned)ax >= (unsigned)w || (unsigned)ay >= (unsigned)h ||
+            (unsigned)bx >= (unsigned)w || (unsigned)by >= (unsigned)h)
+            return true;
+        int set = setOf[ay * w + ax];
+        if (set < 0)
+            return true;
+        int bit = by * w + bx;
+        return (sets[(size_t)set * wordsPerSet + (bit >> 6)] >> (bit & 63)) & 1;
+    }
+
+    // No baked data (no map yet, or one past MAX_BAKE_TILES)
+    bool empty() const { return wordsPerSet == 0; }
+    int uniqueSetCount() const { return wordsPerSet ? (int)(sets.size() / wordsPerSet) : 0; }
+
+    // Baked data as stored in compiled levels: a set index per tile and
+    // (width * height + 63) / 64 words per set
+    const std::vector<int>& tileSets() const { return setOf; }
+    const std::vector<uint64_t>& setWords() const { return sets; }
+    int wordsPerSetCount() const { return wordsPerSet; }
+    void assign(int width, int height, const int32_t* tileSets, const uint64_t* setWords, int setCount);
+
+private:
+    int w = 0, h = 0, wordsPerSet = 0;
+    std::vector<int> setOf;        // per tile, index of its set, -1 = not culled
+    std::vector<uint64_t> sets;    // unique sets, wordsPerSet words each
+};
@@ -0,0 +1,87 @@
+#include "workerPool.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int threadCount) {
+    setThreadCount(threadCount);
+}
+
+WorkerPool::~WorkerPool() {
+    stopThreads();
+}
+
+void WorkerPool::setThreadCount(int threadCount) {
+    if (threadCount <= 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (threadCount == this->threadCount())
+        return;
+
+    stopThreads();
+    stopping = false;
+    for (int i = 1; i < threadCount; i++)
+        threads.emplace_back(&WorkerPool::workerLoop, this, generation);
+}
+
+void WorkerPool::stopThreads() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads)
+        t.join();
+    threads.clear();
+}
+
+void WorkerPool::parallelFor(int count, int bandSize, const std::function<void(int, int)>& fn) {
+    if (count <= 0)
+        return;
+    bandSize = std::max(bandSize, 1);
+    if (threads.empty() || count <= bandSize) {
+        fn(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobCount = count;
+        jobBandSize = bandSize;
+        nextBand.store(0, std::memory_order_relaxed);
+        busyWorkers = (int)threads.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runBands();
+
+    // Wait for the workers to drain their last bands
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]{ return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::runBands() {
+    int bands = (jobCount + jobBandSize - 1) / jobBandSize;
+    for (int b = nextBand.fetch_add(1); b < bands; b = nextBand.fetch_add(1)) {
+        int begin = b * jobBandSize;
+        (*job)(begin, std::min(begin + jobBandSize, jobCount));
+    }
+}
+
+void WorkerPool::workerLoop(unsigned seen) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]{ return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        runBands();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+            done.notify_one();
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads for data-parallel loops.
+// The calling thread takes part in every job, so a pool of size 1 runs
+// everything inline and spawns no threads.
+class WorkerPool {
+public:
+    explicit WorkerPool(int threadCount = 1);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Number of threads working on a job, including the caller.
+    // 0 or less picks one per CPU core.
+    void setThreadCount(int threadCount);
+    int threadCount() const { return (int)threads.size() + 1; }
+
+    // Splits [0, count) into bands of at most bandSize items and runs
+    // fn(begin, end) for each band across the pool. Returns once every
+    // band has finished, so it doubles as the sync point for the caller.
+    void parallelFor(int count, int bandSize, const std::function<void(int, int)>& fn);
+
+private:
+    void workerLoop(unsigned seen);
+    void runBands();
+    void stopThreads();
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    bool stopping = false;
+    unsigned generation = 0;   // bumped once per job
+    int busyWorkers = 0;
+
+    // current job
+    const std::function<void(int, int)>* job = nullptr;
+    int jobCount = 0, jobBandSize = 1;
+    std::atomic<int> nextBand {0};
+};